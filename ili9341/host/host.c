@@ -0,0 +1,861 @@
+/*
+ * ili9341 - ILI9341 SPI LCD Driver for Embedded Systems
+ * Copyright (C) 2013 Fernando Rodriguez (support@fernansoft.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <spi.h>
+#include <rtc.h>
+#include "ili9341.h"
+#include <lg.h>
+
+/*
+// runs the driver against a model of the panel on the host and checks
+// that what ends up on the screen is what the library renders
+*/
+
+#define HOST_SCREEN_WIDTH		320
+#define HOST_SCREEN_HEIGHT		240
+#define HOST_CHART_SAMPLES		100
+#define HOST_STRESS_PRODUCERS	3
+#define HOST_STRESS_REQUESTS	20000
+#define HOST_STRESS_IN_FLIGHT	8
+#define HOST_IMAGE_WIDTH		96
+#define HOST_IMAGE_HEIGHT		64
+#define HOST_IMAGE_PASSES		200
+#define HOST_SPI_CLOCK			9000000UL
+
+volatile int host_spi2buf = HOST_SPI_EMPTY;
+volatile HOST_SPI_STAT SPI2STATbits = { 1 };
+volatile HOST_IFS2 IFS2bits;
+volatile HOST_IEC2 IEC2bits;
+
+void _SPI2Interrupt(void);
+
+/*
+// state of the panel model. The frame memory is indexed by memory
+// row and the memory access control setting used by the driver puts
+// screen column x on memory row 319 - x
+*/
+static LG_RGB frame[HOST_SCREEN_WIDTH][HOST_SCREEN_HEIGHT];
+static int data_line;
+static int command = -1;
+static int argc;
+static unsigned char argv[8];
+static int column_start;
+static int column_end;
+static int page_start;
+static int column;
+static int page;
+static int pixel_byte;
+static unsigned char pixel[3];
+static int scroll_top;
+static int scroll_height = HOST_SCREEN_WIDTH;
+static int scroll_start;
+static int display_on;
+static uint32_t ticks;
+
+/*
+// the number of times each pixel of the frame memory was written
+*/
+static unsigned char writes[HOST_SCREEN_WIDTH][HOST_SCREEN_HEIGHT];
+static volatile uint32_t pixels_written;
+static volatile uint32_t requests_made;
+static volatile int producers_done;
+static pthread_mutex_t producer_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+// bytes sent to the panel and bytes of compressed assets read
+*/
+static uint32_t bus_bytes;
+static uint32_t asset_bytes;
+
+/*
+// takes a byte sent to the panel
+*/
+static void host_panel_byte(unsigned char value)
+{
+	bus_bytes++;
+	if (!data_line)
+	{
+		command = value;
+		argc = 0;
+		if (command == 0x28 || command == 0x29)
+			display_on = (command == 0x29);
+		if (command == 0x2C)
+		{
+			column = column_start;
+			page = page_start;
+			pixel_byte = 0;
+		}
+		return;
+	}
+	if (command == 0x2C)
+	{
+		pixel[pixel_byte++] = value;
+		if (pixel_byte == 3)
+		{
+			pixel_byte = 0;
+			if (column < HOST_SCREEN_WIDTH && page < HOST_SCREEN_HEIGHT)
+			{
+				frame[HOST_SCREEN_WIDTH - 1 - column][page] =
+					((LG_RGB) pixel[0] << 16) | ((LG_RGB) pixel[1] << 8) | pixel[2];
+				if (writes[HOST_SCREEN_WIDTH - 1 - column][page] < 255)
+					writes[HOST_SCREEN_WIDTH - 1 - column][page]++;
+				__sync_fetch_and_add(&pixels_written, 1);
+			}
+			if (++column > column_end)
+			{
+				column = column_start;
+				page++;
+			}
+		}
+		return;
+	}
+	if (argc < 8)
+		argv[argc++] = value;
+	if (command == 0x2A && argc == 4)
+	{
+		column_start = (argv[0] << 8) | argv[1];
+		column_end = (argv[2] << 8) | argv[3];
+	}
+	else if (command == 0x2B && argc == 4)
+	{
+		page_start = (argv[0] << 8) | argv[1];
+	}
+	else if (command == 0x33 && argc == 6)
+	{
+		scroll_top = (argv[0] << 8) | argv[1];
+		scroll_height = (argv[2] << 8) | argv[3];
+	}
+	else if (command == 0x37 && argc == 2)
+	{
+		scroll_start = (argv[0] << 8) | argv[1];
+	}
+}
+
+/*
+// gets the pixel the panel shows at a screen position
+*/
+static LG_RGB host_panel_pixel(int x, int y)
+{
+	int row = HOST_SCREEN_WIDTH - 1 - x;
+	
+	if (row >= scroll_top && row < scroll_top + scroll_height)
+		row = scroll_top + (row - scroll_top + scroll_start - scroll_top + scroll_height) % scroll_height;
+	return frame[row][y];
+}
+
+/*
+// hal stand-in
+*/
+void host_pin_write(int pin, int value)
+{
+	if (pin == 10)
+		data_line = value;
+}
+
+void spi_init(int module)
+{
+}
+
+void spi_set_clock(int module, long clock)
+{
+}
+
+void spi_write_async(int module, unsigned char value)
+{
+	host_panel_byte(value);
+}
+
+char spi_ready(int module)
+{
+	return 1;
+}
+
+void rtc_sleep(uint16_t milliseconds)
+{
+	ticks += milliseconds;
+}
+
+uint32_t rtc_get_ticks(void)
+{
+	return ticks++;
+}
+
+void host_producer_enter(void)
+{
+	pthread_mutex_lock(&producer_lock);
+}
+
+void host_producer_leave(void)
+{
+	pthread_mutex_unlock(&producer_lock);
+}
+
+void host_memory_barrier(void)
+{
+	__sync_synchronize();
+	sched_yield();
+}
+
+/*
+// shifts out the byte written to SPI2BUF and raises the
+// spi interrupt
+*/
+void host_spi_run(void)
+{
+	if (host_spi2buf != HOST_SPI_EMPTY)
+	{
+		host_panel_byte((unsigned char) host_spi2buf);
+		host_spi2buf = HOST_SPI_EMPTY;
+		IFS2bits.SPI2IF = 1;
+	}
+	#if defined(ILI9341_USE_SPI_INTERRUPT)
+		if (IFS2bits.SPI2IF && IEC2bits.SPI2IE)
+			_SPI2Interrupt();
+	#endif
+}
+
+/*
+// runs the driver until everything requested is on the panel
+*/
+static void host_paint(void)
+{
+	uint32_t i;
+	
+	for (i = 0; i < 100000000UL; i++)
+	{
+		host_spi_run();
+		ili9341_do_processing();
+		if (!ili9341_is_painting() && host_spi2buf == HOST_SPI_EMPTY && !IEC2bits.SPI2IE)
+			return;
+	}
+}
+
+/*
+// counts the pixels on the panel that differ from the scene
+*/
+static uint32_t host_compare(void)
+{
+	int x;
+	int y;
+	uint32_t errors = 0;
+	LG_RGB span[HOST_SCREEN_WIDTH];
+	
+	for (y = 0; y < HOST_SCREEN_HEIGHT; y++)
+	{
+		lg_render_span(0, y, HOST_SCREEN_WIDTH, span);
+		for (x = 0; x < HOST_SCREEN_WIDTH; x++)
+		{
+			if ((span[x] & 0x7E7E7E) != host_panel_pixel(x, y))
+				errors++;
+		}
+	}
+	return errors;
+}
+
+/*
+// reports the result of a check
+*/
+static int host_check(const char* name, uint32_t errors)
+{
+	printf("%-32s %s (%lu)\n", name, errors ? "FAILED" : "ok", (unsigned long) errors);
+	return errors != 0;
+}
+
+/*
+// reports a value that must match the one computed by hand
+*/
+static int host_check_value(const char* name, uint32_t value, uint32_t expected)
+{
+	printf("%-32s %s (%lu, expected %lu)\n", name, value != expected ? "FAILED" : "ok", 
+		(unsigned long) value, (unsigned long) expected);
+	return value != expected;
+}
+
+/*
+// paints a scene with static elements and a scrolling chart, the
+// samples are added while the previous one is still being painted
+*/
+static int host_test_scene(void)
+{
+	int i;
+	int j;
+	int failed = 0;
+	uint32_t errors = 0;
+	int16_t chart;
+	static unsigned char samples[HOST_CHART_SAMPLES];
+	
+	lg_set_background(0x202020);
+	host_paint();
+	failed |= host_check("background", host_compare());
+	
+	lg_rect_add(10, 10, 30, 20, 0xFF0000);
+	lg_label_add((unsigned char*) "ILI9341", 0, 2, 1, 0x00FF00, 180, 20);
+	chart = lg_chart_add(samples, 50, 0, HOST_CHART_SAMPLES, HOST_SCREEN_HEIGHT, 0, 100, 
+		LG_CHART_SCROLL, 0xFCFCFC, 0x000080);
+	host_paint();
+	failed |= host_check("elements", host_compare());
+	
+	for (i = 0; i < 2 * HOST_CHART_SAMPLES; i++)
+	{
+		lg_chart_add_sample(chart, (i * 37) % 100);
+		host_paint();
+	}
+	failed |= host_check("chart scrolled", host_compare());
+	
+	for (i = 0; i < HOST_CHART_SAMPLES; i++)
+	{
+		lg_chart_add_sample(chart, (i * 37) % 100);
+		for (j = 0; j < 300 + i * 20; j++)
+		{
+			host_spi_run();
+			ili9341_do_processing();
+		}
+		lg_chart_add_sample(chart, (i * 53) % 100);
+		host_paint();
+		errors += host_compare();
+	}
+	failed |= host_check("chart scrolled while painting", errors);
+	
+	ili9341_paint();
+	host_paint();
+	failed |= host_check("full repaint", host_compare());
+	
+	/*
+	// the display is turned off and on in the middle of painting
+	// a new background
+	*/
+	lg_set_background(0x204020);
+	for (i = 0; i < 5000; i++)
+	{
+		host_spi_run();
+		ili9341_do_processing();
+	}
+	ili9341_display_off();
+	host_paint();
+	failed |= host_check("display off while painting", host_compare() + display_on);
+	lg_set_background(0x202020);
+	for (i = 0; i < 5000; i++)
+	{
+		host_spi_run();
+		ili9341_do_processing();
+	}
+	ili9341_display_on();
+	host_paint();
+	failed |= host_check("display on while painting", host_compare() + !display_on);
+	return failed;
+}
+
+/*
+// adds rectangles on two columns in turns on different rows. Only
+// the requests of each column share an address so nothing is saved
+// unless the driver reorders them to skip sending it again
+*/
+static int host_test_windows(void)
+{
+	int i;
+	int failed = 0;
+	uint32_t saved = ili9341_get_bytes_saved();
+	
+	for (i = 0; i < 8; i++)
+	{
+		lg_rect_add(270, 40 + i * 25, 20, 10, 0xFFFF00);
+		lg_rect_add(295, 52 + i * 25, 20, 10, 0x00FFFF);
+	}
+	host_paint();
+	saved = ili9341_get_bytes_saved() - saved;
+	printf("%-32s %lu\n", "command bytes saved", (unsigned long) saved);
+	failed |= host_check("shared columns saved bytes", !saved);
+	failed |= host_check("rectangles painted", host_compare());
+	return failed;
+}
+
+#if defined(ILI9341_TRACE)
+
+/*
+// a trace of two frames. The first paints two windows of 10 by 10
+// pixels on the same columns that overlap by 5 rows, the column
+// addresses of the second are sent again. The second frame is a
+// display on command
+*/
+static const unsigned char trace_fixed[] =
+{
+	ILI9341_TRACE_COMMAND, 0x2A, 
+	ILI9341_TRACE_DATA, 0, ILI9341_TRACE_DATA, 10, ILI9341_TRACE_DATA, 0, ILI9341_TRACE_DATA, 19, 
+	ILI9341_TRACE_COMMAND, 0x2B, 
+	ILI9341_TRACE_DATA, 0, ILI9341_TRACE_DATA, 0, ILI9341_TRACE_DATA, 0, ILI9341_TRACE_DATA, 9, 
+	ILI9341_TRACE_COMMAND, 0x2C, 
+	ILI9341_TRACE_PIXELS, 100, 0, 
+	ILI9341_TRACE_COMMAND, 0x2A, 
+	ILI9341_TRACE_DATA, 0, ILI9341_TRACE_DATA, 10, ILI9341_TRACE_DATA, 0, ILI9341_TRACE_DATA, 19, 
+	ILI9341_TRACE_COMMAND, 0x2B, 
+	ILI9341_TRACE_DATA, 0, ILI9341_TRACE_DATA, 5, ILI9341_TRACE_DATA, 0, ILI9341_TRACE_DATA, 14, 
+	ILI9341_TRACE_COMMAND, 0x2C, 
+	ILI9341_TRACE_PIXELS, 100, 0, 
+	ILI9341_TRACE_IDLE, 
+	ILI9341_TRACE_COMMAND, 0x29, 
+	ILI9341_TRACE_IDLE
+};
+
+/*
+// records two requests on the same columns that overlap by 20 rows
+// after a full paint and checks what the analyzer makes of them:
+//
+// the first window sets the column and page addresses (5 bytes each)
+// and the memory write (1 byte), the second only the page addresses
+// and the memory write since the driver doesn't send the columns
+// again. Nothing else is sent. The second window paints the 50 by
+// 20 pixels the first one did again
+*/
+static int host_test_trace(void)
+{
+	int failed = 0;
+	uint16_t length;
+	ILI9341_TRACE_STATS stats;
+	static unsigned char trace[64];
+	
+	ili9341_paint();
+	host_paint();
+	ili9341_trace_start(trace, sizeof(trace));
+	ili9341_paint_partial(40, 20, 50, 30);
+	ili9341_paint_partial(40, 30, 50, 40);
+	host_paint();
+	/*
+	// the end of the frame is recorded on the next call
+	*/
+	ili9341_do_processing();
+	length = ili9341_trace_stop();
+	
+	failed |= host_check("trace analyzed", !ili9341_trace_analyze(trace, length, HOST_SPI_CLOCK, &stats));
+	failed |= host_check_value("trace window bytes", stats.window_bytes, 17);
+	failed |= host_check_value("trace scroll bytes", stats.scroll_bytes, 0);
+	failed |= host_check_value("trace other bytes", stats.other_bytes, 0);
+	failed |= host_check_value("trace pixels", stats.pixels, 50 * 30 + 50 * 40);
+	failed |= host_check_value("trace pixel bytes", stats.pixel_bytes, (50 * 30 + 50 * 40) * 3);
+	failed |= host_check_value("trace windows", stats.windows, 2);
+	failed |= host_check_value("trace redundant windows", stats.redundant_windows, 0);
+	failed |= host_check_value("trace overdraw", stats.overdraw, 50 * 20);
+	failed |= host_check_value("trace frames", stats.frames, 1);
+	failed |= host_check_value("trace bus time", stats.bus_time, (17 + 10500) * 8 / 9);
+	
+	/*
+	// the fourth column address byte doesn't fit, the end of
+	// frame that comes after it would but is not recorded
+	*/
+	ili9341_trace_start(trace, 9);
+	ili9341_paint_partial(40, 20, 50, 30);
+	host_paint();
+	ili9341_do_processing();
+	length = ili9341_trace_stop();
+	failed |= host_check_value("full trace length", length, 8);
+	failed |= host_check("full trace analyzed", !ili9341_trace_analyze(trace, length, HOST_SPI_CLOCK, &stats));
+	failed |= host_check_value("full trace frames", stats.frames, 0);
+	
+	failed |= host_check("fixed trace analyzed", !ili9341_trace_analyze(trace_fixed, sizeof(trace_fixed), 
+		HOST_SPI_CLOCK, &stats));
+	failed |= host_check_value("fixed trace window bytes", stats.window_bytes, 22);
+	failed |= host_check_value("fixed trace other bytes", stats.other_bytes, 1);
+	failed |= host_check_value("fixed trace redundant windows", stats.redundant_windows, 1);
+	failed |= host_check_value("fixed trace overdraw", stats.overdraw, 10 * 5);
+	failed |= host_check_value("fixed trace frames", stats.frames, 2);
+	return failed;
+}
+
+/*
+// predicts the time of the fixed trace with a byte taking 1000ns, a
+// switch between commands and data 100ns and rendering a pixel 50ns:
+//
+// the first frame sends 22 window bytes and 600 pixel bytes with 11
+// switches, 623100ns, and renders 200 pixels, 10000ns. That's 633us
+// or 623us if rendering overlaps the transfers. The second frame
+// sends a command after pixel data, 1100ns, so it takes 1us
+*/
+static int host_test_estimate(void)
+{
+	int failed = 0;
+	ILI9341_COST_MODEL model = { 8000000UL, 0, 100, 50, 0 };
+	ILI9341_TRACE_ESTIMATE estimate;
+	
+	failed |= host_check("estimate", !ili9341_trace_estimate(trace_fixed, sizeof(trace_fixed), 
+		&model, &estimate));
+	failed |= host_check_value("estimate frames", estimate.frames, 2);
+	failed |= host_check_value("estimate total us", estimate.total_time, 633 + 1);
+	failed |= host_check_value("estimate worst us", estimate.worst_frame_time, 633);
+	failed |= host_check_value("estimate average us", estimate.average_frame_time, 634 / 2);
+	failed |= host_check_value("estimate fps", estimate.fps, 1000000UL / (634 / 2));
+	
+	model.overlapped = 1;
+	failed |= host_check("overlapped estimate", !ili9341_trace_estimate(trace_fixed, sizeof(trace_fixed), 
+		&model, &estimate));
+	failed |= host_check_value("overlapped estimate total us", estimate.total_time, 623 + 1);
+	failed |= host_check_value("overlapped estimate worst us", estimate.worst_frame_time, 623);
+	failed |= host_check_value("overlapped estimate fps", estimate.fps, 1000000UL / (624 / 2));
+	return failed;
+}
+
+#endif
+
+/*
+// encodes an image as QOI without alpha. Returns the size
+*/
+static uint32_t host_qoi_encode(const LG_RGB* pixels, uint16_t width, uint16_t height, unsigned char* out)
+{
+	uint32_t i;
+	uint32_t size = 0;
+	unsigned char run = 0;
+	unsigned char index[64][3];
+	unsigned char px[3];
+	unsigned char prev[3] = { 0, 0, 0 };
+	unsigned char hash;
+	signed char vr;
+	signed char vg;
+	signed char vb;
+	
+	memset(index, 0, sizeof(index));
+	memcpy(out, "qoif", 4);
+	out[4] = 0;
+	out[5] = 0;
+	out[6] = width >> 8;
+	out[7] = width;
+	out[8] = 0;
+	out[9] = 0;
+	out[10] = height >> 8;
+	out[11] = height;
+	out[12] = 3;
+	out[13] = 0;
+	size = 14;
+	
+	for (i = 0; i < (uint32_t) width * height; i++)
+	{
+		px[0] = pixels[i] >> 16;
+		px[1] = pixels[i] >> 8;
+		px[2] = pixels[i];
+		if (!memcmp(px, prev, 3))
+		{
+			if (++run == 62 || i == (uint32_t) width * height - 1)
+			{
+				out[size++] = 0xC0 | (run - 1);
+				run = 0;
+			}
+			continue;
+		}
+		if (run)
+		{
+			out[size++] = 0xC0 | (run - 1);
+			run = 0;
+		}
+		hash = (px[0] * 3 + px[1] * 5 + px[2] * 7 + 255 * 11) & 63;
+		vr = px[0] - prev[0];
+		vg = px[1] - prev[1];
+		vb = px[2] - prev[2];
+		if (!memcmp(index[hash], px, 3))
+		{
+			out[size++] = hash;
+		}
+		else if (vr >= -2 && vr <= 1 && vg >= -2 && vg <= 1 && vb >= -2 && vb <= 1)
+		{
+			out[size++] = 0x40 | ((vr + 2) << 4) | ((vg + 2) << 2) | (vb + 2);
+		}
+		else if (vg >= -32 && vg <= 31 && vr - vg >= -8 && vr - vg <= 7 && vb - vg >= -8 && vb - vg <= 7)
+		{
+			out[size++] = 0x80 | (vg + 32);
+			out[size++] = ((vr - vg + 8) << 4) | (vb - vg + 8);
+		}
+		else
+		{
+			out[size++] = 0xFE;
+			out[size++] = px[0];
+			out[size++] = px[1];
+			out[size++] = px[2];
+		}
+		memcpy(index[hash], px, 3);
+		memcpy(prev, px, 3);
+	}
+	memset(&out[size], 0, 7);
+	out[size + 7] = 1;
+	return size + 8;
+}
+
+/*
+// reads a QOI image from memory as if it was on an external flash
+// and counts the bytes read
+*/
+static uint16_t host_asset_read(void* context, uint32_t offset, unsigned char* buffer, uint16_t length)
+{
+	const unsigned char* data = (const unsigned char*) context;
+	uint32_t size = ((uint32_t) data[0] << 24) | ((uint32_t) data[1] << 16) | 
+		((uint32_t) data[2] << 8) | data[3];
+	
+	if (offset >= size)
+		return 0;
+	if (length > size - offset)
+		length = size - offset;
+	memcpy(buffer, &data[4 + offset], length);
+	asset_bytes += length;
+	return length;
+}
+
+/*
+// gets the nanoseconds it takes to render an area of the screen
+// once, averaged over a number of passes
+*/
+static uint32_t host_render_time(uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+	int i;
+	uint16_t row;
+	struct timespec start;
+	struct timespec end;
+	LG_RGB span[HOST_SCREEN_WIDTH];
+	
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < HOST_IMAGE_PASSES; i++)
+	{
+		for (row = 0; row < height; row++)
+			lg_render_span(x, y + row, width, span);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (uint32_t) (((end.tv_sec - start.tv_sec) * 1000000000LL + 
+		(end.tv_nsec - start.tv_nsec)) / HOST_IMAGE_PASSES);
+}
+
+/*
+// prints the cost of painting an image, the bus time is the time
+// it takes to read the asset and send the pixels at the spi clock
+*/
+static void host_image_report(const char* name, uint32_t asset, uint32_t bus, uint32_t render)
+{
+	printf("%-32s %lu asset bytes, %lu bus bytes, %lu us bus, %lu us render\n", name, 
+		(unsigned long) asset, (unsigned long) bus, 
+		(unsigned long) ((uint64_t) (asset + bus) * 8 * 1000000UL / HOST_SPI_CLOCK), 
+		(unsigned long) (render / 1000));
+}
+
+/*
+// paints the same image stored as RGB565 and as QOI and checks
+// that they look the same. Reports the asset size, the bytes sent
+// to the panel and the time it takes to decode each one
+*/
+static int host_test_images(void)
+{
+	int x;
+	int y;
+	int failed = 0;
+	uint32_t errors = 0;
+	uint32_t bus;
+	uint32_t render;
+	uint32_t size;
+	uint16_t pixel;
+	LG_RGB rgb565_span[HOST_IMAGE_WIDTH];
+	LG_RGB qoi_span[HOST_IMAGE_WIDTH];
+	static unsigned char rgb565[HOST_IMAGE_WIDTH * HOST_IMAGE_HEIGHT * 2];
+	static LG_RGB pixels[HOST_IMAGE_WIDTH * HOST_IMAGE_HEIGHT];
+	static unsigned char qoi_data[4 + 14 + HOST_IMAGE_WIDTH * HOST_IMAGE_HEIGHT * 4 + 8];
+	static LG_BITMAP bitmap;
+	static LG_QOI qoi;
+	
+	/*
+	// a flat header, a gradient and a busy pattern like
+	// the ones found on user interfaces
+	*/
+	for (y = 0; y < HOST_IMAGE_HEIGHT; y++)
+	{
+		for (x = 0; x < HOST_IMAGE_WIDTH; x++)
+		{
+			if (y < 16)
+				pixel = 0x001F;
+			else if (y < 40)
+				pixel = (((x * 31) / HOST_IMAGE_WIDTH) << 11) | (((y * 63) / HOST_IMAGE_HEIGHT) << 5);
+			else
+				pixel = ((x ^ y) & 4) ? 0xFFFF : (uint16_t) (x * 683 + y * 173);
+			rgb565[(y * HOST_IMAGE_WIDTH + x) * 2] = (unsigned char) pixel;
+			rgb565[(y * HOST_IMAGE_WIDTH + x) * 2 + 1] = (unsigned char) (pixel >> 8);
+		}
+	}
+	bitmap.format = LG_BITMAP_RGB565;
+	bitmap.width = HOST_IMAGE_WIDTH;
+	bitmap.height = HOST_IMAGE_HEIGHT;
+	bitmap.palette = NULL;
+	bitmap.data = rgb565;
+	lg_image_add(&bitmap, 160, 60, 0);
+	host_paint();
+	bus_bytes = 0;
+	ili9341_paint_partial(160, 60, HOST_IMAGE_WIDTH, HOST_IMAGE_HEIGHT);
+	host_paint();
+	bus = bus_bytes;
+	render = host_render_time(160, 60, HOST_IMAGE_WIDTH, HOST_IMAGE_HEIGHT);
+	host_image_report("rgb565 image", sizeof(rgb565), bus, render);
+	
+	/*
+	// encode what the RGB565 image renders to so the two must match
+	*/
+	for (y = 0; y < HOST_IMAGE_HEIGHT; y++)
+		lg_render_span(160, 60 + y, HOST_IMAGE_WIDTH, &pixels[y * HOST_IMAGE_WIDTH]);
+	size = host_qoi_encode(pixels, HOST_IMAGE_WIDTH, HOST_IMAGE_HEIGHT, &qoi_data[4]);
+	qoi_data[0] = size >> 24;
+	qoi_data[1] = size >> 16;
+	qoi_data[2] = size >> 8;
+	qoi_data[3] = size;
+	failed |= host_check("qoi image opened", !lg_qoi_open(&qoi, host_asset_read, qoi_data));
+	lg_qoi_add(&qoi, 160, 140);
+	host_paint();
+	bus_bytes = 0;
+	asset_bytes = 0;
+	ili9341_paint_partial(160, 140, HOST_IMAGE_WIDTH, HOST_IMAGE_HEIGHT);
+	host_paint();
+	bus = bus_bytes;
+	size = asset_bytes;
+	render = host_render_time(160, 140, HOST_IMAGE_WIDTH, HOST_IMAGE_HEIGHT);
+	host_image_report("qoi image", size, bus, render);
+	
+	for (y = 0; y < HOST_IMAGE_HEIGHT; y++)
+	{
+		lg_render_span(160, 60 + y, HOST_IMAGE_WIDTH, rgb565_span);
+		lg_render_span(160, 140 + y, HOST_IMAGE_WIDTH, qoi_span);
+		for (x = 0; x < HOST_IMAGE_WIDTH; x++)
+		{
+			if (rgb565_span[x] != qoi_span[x])
+				errors++;
+		}
+	}
+	failed |= host_check("qoi matches rgb565", errors);
+	failed |= host_check("images painted", host_compare());
+	return failed;
+}
+
+/*
+// makes one pixel paint requests for it's share of the screen. The
+// requests in flight are limited so the ring doesn't overflow, that
+// would paint the whole screen
+*/
+static void* host_producer(void* arg)
+{
+	int producer = (int) (intptr_t) arg;
+	uint32_t i;
+	uint32_t pixel;
+	
+	for (i = 0; i < HOST_STRESS_REQUESTS; i++)
+	{
+		while (requests_made - pixels_written >= HOST_STRESS_IN_FLIGHT)
+			sched_yield();
+		pixel = i * HOST_STRESS_PRODUCERS + producer;
+		__sync_fetch_and_add(&requests_made, 1);
+		ili9341_paint_partial(pixel % HOST_SCREEN_WIDTH, pixel / HOST_SCREEN_WIDTH, 1, 1);
+	}
+	__sync_fetch_and_add(&producers_done, 1);
+	return NULL;
+}
+
+/*
+// makes paint requests from several threads while the driver paints
+// them and checks that each one was painted once
+*/
+static int host_test_stress(void)
+{
+	int i;
+	int x;
+	int y;
+	int failed = 0;
+	uint32_t lost = 0;
+	uint32_t duplicated = 0;
+	uint32_t pixel;
+	pthread_t threads[HOST_STRESS_PRODUCERS];
+	
+	#if defined(ILI9341_TILE_HASHING)
+		/*
+		// the driver forgets what's on the tiles of a scroll area so
+		// none of the requests is skipped and each writes one pixel
+		*/
+		ili9341_set_scroll_area(0, HOST_SCREEN_WIDTH);
+		host_paint();
+	#endif
+	ili9341_set_scroll_area(0, 0);
+	host_paint();
+	memset(writes, 0, sizeof(writes));
+	pixels_written = 0;
+	requests_made = 0;
+	producers_done = 0;
+	
+	for (i = 0; i < HOST_STRESS_PRODUCERS; i++)
+		pthread_create(&threads[i], NULL, host_producer, (void*) (intptr_t) i);
+	while (producers_done < HOST_STRESS_PRODUCERS || ili9341_is_painting() || 
+		host_spi2buf != HOST_SPI_EMPTY || IEC2bits.SPI2IE)
+	{
+		host_spi_run();
+		ili9341_do_processing();
+	}
+	for (i = 0; i < HOST_STRESS_PRODUCERS; i++)
+		pthread_join(threads[i], NULL);
+	
+	for (y = 0; y < HOST_SCREEN_HEIGHT; y++)
+	{
+		for (x = 0; x < HOST_SCREEN_WIDTH; x++)
+		{
+			pixel = (uint32_t) y * HOST_SCREEN_WIDTH + x;
+			if (pixel < (uint32_t) HOST_STRESS_PRODUCERS * HOST_STRESS_REQUESTS && 
+				!writes[HOST_SCREEN_WIDTH - 1 - x][y])
+			{
+				lost++;
+			}
+			else if (writes[HOST_SCREEN_WIDTH - 1 - x][y] > 1 || 
+				(pixel >= (uint32_t) HOST_STRESS_PRODUCERS * HOST_STRESS_REQUESTS && 
+				writes[HOST_SCREEN_WIDTH - 1 - x][y]))
+			{
+				duplicated++;
+			}
+		}
+	}
+	failed |= host_check("threaded requests lost", lost);
+	failed |= host_check("threaded requests duplicated", duplicated);
+	failed |= host_check("threaded requests painted", host_compare());
+	return failed;
+}
+
+int main(void)
+{
+	int failed = 0;
+	
+	ili9341_init();
+	lg_init(ili9341_paint, (LG_DISPLAY_PAINT_PARTIAL) ili9341_paint_partial);
+	lg_set_busy_callback(ili9341_is_painting);
+	lg_set_scroll_callback(ili9341_scroll);
+	
+	#if defined(ILI9341_USE_SPI_INTERRUPT)
+		printf("spi interrupt pump\n");
+	#else
+		printf("polled pump\n");
+	#endif
+	#if defined(ILI9341_TILE_HASHING)
+		printf("tile hashing\n");
+	#endif
+	#if defined(ILI9341_TRACE)
+		printf("trace\n");
+		failed |= host_test_trace();
+		failed |= host_test_estimate();
+	#endif
+	failed |= host_test_scene();
+	failed |= host_test_windows();
+	failed |= host_test_images();
+	failed |= host_test_stress();
+	return failed;
+}
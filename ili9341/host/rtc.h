@@ -0,0 +1,33 @@
+/*
+ * ili9341 - ILI9341 SPI LCD Driver for Embedded Systems
+ * Copyright (C) 2013 Fernando Rodriguez (support@fernansoft.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef RTC_H
+#define RTC_H
+
+#include <stdint.h>
+
+/*
+// host stand-in for the dspic_hal rtc driver. Time only moves when
+// it's read or slept on, one millisecond per read
+*/
+void rtc_sleep(uint16_t milliseconds);
+uint32_t rtc_get_ticks(void);
+
+#endif
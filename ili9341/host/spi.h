@@ -0,0 +1,93 @@
+/*
+ * ili9341 - ILI9341 SPI LCD Driver for Embedded Systems
+ * Copyright (C) 2013 Fernando Rodriguez (support@fernansoft.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef SPI_H
+#define SPI_H
+
+#include <stdint.h>
+
+/*
+// host stand-in for the dspic_hal spi driver and the registers used by
+// the ili9341 driver. Bytes written with spi_write_async are handed to
+// the panel right away. Bytes written to SPI2BUF by the interrupt handler
+// are shifted out by host_spi_run, which also raises the SPI2 interrupt
+*/
+#define SPI_GET_MODULE(module)				(module)
+#define Nop()
+#define IO_PIN_WRITE(port, pin, value)		host_pin_write(pin, value)
+#define IO_PIN_SET_AS_OUTPUT(port, pin)
+#define ILI9341_ISR_ATTRIBUTES
+
+/*
+// paint requests are made from several threads on the host so the
+// producers take a lock where the target holds off interrupts. The
+// lock is used on purpose instead of a lock free ring with atomics
+// so the host runs the same ring code as the target. The barrier
+// also yields to the other threads so they get to run between
+// filling an entry and publishing it
+*/
+#define ILI9341_ENTER_PRODUCER(disi)		((disi) = 0, host_producer_enter())
+#define ILI9341_LEAVE_PRODUCER(disi)		((void) (disi), host_producer_leave())
+#define ILI9341_MEMORY_BARRIER()			host_memory_barrier()
+
+/*
+// SPI2BUF holds HOST_SPI_EMPTY while there's nothing to shift out
+*/
+#define HOST_SPI_EMPTY						(-1)
+#define SPI2BUF								host_spi2buf
+
+typedef struct HOST_SPI_STAT
+{
+	unsigned SPIRBF : 1;
+}
+HOST_SPI_STAT;
+
+typedef struct HOST_IFS2
+{
+	unsigned SPI2IF : 1;
+}
+HOST_IFS2;
+
+typedef struct HOST_IEC2
+{
+	unsigned SPI2IE : 1;
+}
+HOST_IEC2;
+
+extern volatile int host_spi2buf;
+extern volatile HOST_SPI_STAT SPI2STATbits;
+extern volatile HOST_IFS2 IFS2bits;
+extern volatile HOST_IEC2 IEC2bits;
+
+void spi_init(int module);
+void spi_set_clock(int module, long clock);
+void spi_write_async(int module, unsigned char value);
+char spi_ready(int module);
+
+/*
+// functions of the host program
+*/
+void host_pin_write(int pin, int value);
+void host_spi_run(void);
+void host_producer_enter(void);
+void host_producer_leave(void);
+void host_memory_barrier(void);
+
+#endif
@@ -20,16 +20,21 @@
 
 #include <spi.h> 
 #include <rtc.h>
+#include <string.h>
 #include "ili9341.h"
 #include <lg.h>
 
+#if !defined(MIN)
+#define MIN(a, b)			(((a) < (b)) ? (a) : (b))
+#define MAX(a, b)			(((a) > (b)) ? (a) : (b))
+#endif
+
 typedef struct ILI9341_PARTIAL_PAINT
 {
 	unsigned int x;
 	unsigned int y;
 	unsigned int width;
 	unsigned int height;
-	unsigned char pending;
 }
 ILI9341_PARTIAL_PAINT;
 
@@ -44,17 +49,109 @@ static unsigned int x_end;
 static unsigned int y_start;
 static unsigned int y_end;
 static unsigned char current_byte = 0;
+static uint16_t split_x;
+static uint16_t split_y;
+static uint16_t split_width;
+static uint16_t split_height;
+static uint16_t scroll_x;
+static uint16_t scroll_width;
+static uint16_t scroll_offset;
+static uint16_t scroll_next_x;
+static uint16_t scroll_next_width;
+static uint16_t scroll_next_offset;
+static unsigned char scroll_pending;
 
 #if defined(ILI9341_ENQUEUE_PAINT_REQUESTS)
+	/*
+	// paint requests are queued on a multiple producer, single consumer
+	// ring. The head is only written by ili9341_paint_partial and the
+	// tail only by ili9341_do_processing. Requests can come from the
+	// application loop and from interrupt handlers, the producers are
+	// serialized by ILI9341_ENTER_PRODUCER. If the ring fills up the
+	// overflow flag is set and the whole screen is painted once the
+	// ring is drained
+	*/
 	static ILI9341_PARTIAL_PAINT partial_paint[ILI9341_PARTIAL_PAINT_LIMIT];
-	static unsigned int partial_paint_index;
-	static unsigned int partial_paint_head;
+	static volatile unsigned int partial_paint_head;
+	static volatile unsigned int partial_paint_tail;
+	static volatile unsigned char partial_paint_overflow;
+	static ILI9341_PARTIAL_PAINT last_request;
+#endif
+
+/*
+// keeps the compiler from moving memory accesses across it, the
+// dsPIC doesn't reorder them
+*/
+#if !defined(ILI9341_MEMORY_BARRIER)
+	#define ILI9341_MEMORY_BARRIER()		__asm__ __volatile__("" ::: "memory")
+#endif
+
+/*
+// serializes the producers of the paint request ring by holding off
+// interrupts while a request is added. Requests must not be made from
+// priority 7 interrupt handlers since DISI doesn't hold them off. The
+// DISI count of the caller is saved and restored so requests can be
+// made from code that already holds off interrupts, it's then held
+// off for a little longer than the caller asked for
+*/
+#if !defined(ILI9341_ENTER_PRODUCER)
+	#define ILI9341_ENTER_PRODUCER(disi)	disi = DISICNT; __builtin_disi(0x3FFF)
+	#define ILI9341_LEAVE_PRODUCER(disi)	DISICNT = disi
 #endif
 
 /*
 // configuration
 */
 #define ILI9341_GET_PIXEL(x, y)			lg_get_pixel(x, y)			/* function to get pixel value */
+#define ILI9341_GET_SPAN(x, y, w, span)	lg_render_span(x, y, w, span)	/* function to get a span of pixels */
+/*
+// function that returns a free running millisecond tick count used to time
+// the delays of the init, sleep and wake sequences without blocking. It can
+// be defined on the command line to use another timer
+*/
+#if !defined(ILI9341_GET_TICKS)
+	#define ILI9341_GET_TICKS()			rtc_get_ticks()
+#endif
+/*
+// function that returns a free running microsecond count used to limit the
+// time spent on ili9341_do_processing_budget. By default it's made from the
+// tick count so budgets are only as fine as one millisecond, platforms with
+// a faster timer should define it on the command line
+*/
+#if !defined(ILI9341_GET_MICROSECONDS)
+	#define ILI9341_GET_MICROSECONDS()	((uint32_t) ILI9341_GET_TICKS() * 1000UL)
+#endif
+/*
+// define ILI9341_USE_SPI_INTERRUPT to send the pixels from the spi interrupt,
+// the application loop then only renders the next row while the current one
+// is sent. The driver defines the SPI2 interrupt handler
+*/
+//#define ILI9341_USE_SPI_INTERRUPT
+/*
+// define ILI9341_TRACE to be able to record the bytes sent to the display
+// with ili9341_trace_start. It must be defined on the command line so
+// ili9341.h declares the trace functions too
+*/
+//#define ILI9341_TRACE
+/*
+// define ILI9341_TILE_HASHING to keep a hash of every tile of the screen as
+// it was last sent to the display. Damaged regions are rendered one band of
+// tiles at a time into a buffer, the tiles that didn't change are skipped
+// and the rest are sent from the buffer. The band buffer and the hashes
+// take about 15KB of RAM. It must be defined on the command line so
+// ili9341.h declares ili9341_get_tiles_skipped too
+*/
+//#define ILI9341_TILE_HASHING
+/*
+// attributes of the spi interrupt handler, the host stand-in of the
+// hal defines them as nothing
+*/
+#if !defined(ILI9341_ISR_ATTRIBUTES)
+	#define ILI9341_ISR_ATTRIBUTES			__attribute__((__interrupt__, __no_auto_psv__))
+#endif
+#define ILI9341_SPI_INTERRUPT_CLEAR()		IFS2bits.SPI2IF = 0
+#define ILI9341_SPI_INTERRUPT_ENABLE()		IEC2bits.SPI2IE = 1
+#define ILI9341_SPI_INTERRUPT_DISABLE()		IEC2bits.SPI2IE = 0
 #define ILI9341_ASSERT_CS()						/* assert chip-select macro */
 #define ILI9341_DEASSERT_CS()					/* de-assert chip-select macro */
 #define ILI9341_ASSERT_DATA()			IO_PIN_WRITE(B, 10, 1); Nop(); Nop()
@@ -100,6 +197,8 @@ static unsigned char current_byte = 0;
 #define ILI9341_CMD_GAMMA_SET								(0x26)
 #define ILI9341_CMD_POSITIVE_GAMMA_CORRECTION				(0xE0)
 #define ILI9341_CMD_NEGATIVE_GAMMA_CORRECTION				(0xE1)
+#define ILI9341_CMD_VERTICAL_SCROLLING_DEFINITION			(0x33)
+#define ILI9341_CMD_VERTICAL_SCROLLING_START_ADDRESS		(0x37)
 
 
 /*
@@ -138,17 +237,101 @@ static unsigned char current_byte = 0;
 #define LCD_SCREEN_WIDTH 320
 #define LCD_SCREEN_HEIGHT 240
 
-static unsigned char delay_temp;
+/*
+// the display is used in landscape mode so the panel's vertical
+// scrolling moves the contents horizontally. With the memory access
+// control setting used by ili9341_init the first line of the frame
+// memory is on the right edge of the screen, undefine this if the
+// memory access control setting is changed so it's on the left
+*/
+#define ILI9341_SCROLL_REVERSED
 
 /*
-// macro for writing data via spi
+// command sequence opcodes. Each entry of a sequence is a command followed
+// by the number of argument bytes and the arguments, or one of these. The
+// values are not valid commands
 */
-#define LCD_WRITE_DATA(data)				\
-{											\
-	for(delay_temp=0; delay_temp < 0x7f; delay_temp++);								\
-	ILI9341_ASSERT_DATA();					\
-	spi_write(SPI_GET_MODULE(2), data);		\
-}
+#define ILI9341_SEQ_END										(0x00)
+#define ILI9341_SEQ_DELAY									(0xFF)	/* followed by milliseconds */
+#define ILI9341_SEQ_DEASSERT_RESET							(0xFE)
+
+static unsigned char spi_busy;
+static unsigned char window_valid;
+static uint16_t window_x1;
+static uint16_t window_x2;
+static uint16_t window_y1;
+static uint16_t window_y2;
+static uint32_t bytes_saved;
+
+#if defined(ILI9341_TRACE)
+	static unsigned char* trace_buffer;
+	static uint16_t trace_size;
+	static uint16_t trace_length;
+	static uint16_t trace_pixels;
+	static unsigned char trace_busy;
+	static unsigned char trace_full;
+	/*
+	// the number of windows per frame that are checked for overdraw
+	*/
+	#define ILI9341_TRACE_MAX_WINDOWS		16
+#endif
+static LG_RGB span[LCD_SCREEN_WIDTH];
+static const unsigned char* seq;
+static const unsigned char* seq_next;
+static unsigned char seq_delay;
+static uint32_t seq_delay_start;
+
+#if defined(ILI9341_USE_SPI_INTERRUPT)
+	/*
+	// rows are rendered into one buffer while the other one is
+	// being sent by the interrupt handler
+	*/
+	static LG_RGB span_back[LCD_SCREEN_WIDTH];
+	static LG_RGB* row_buffer = span_back;
+	static unsigned char row_ready;
+	static LG_RGB* volatile isr_span;
+	static volatile uint16_t isr_pixels;
+	static volatile unsigned char isr_byte;
+	static volatile unsigned char isr_active;
+#endif
+
+#if defined(ILI9341_TILE_HASHING)
+	#if !defined(ILI9341_ENQUEUE_PAINT_REQUESTS)
+		#error ILI9341_TILE_HASHING requires ILI9341_ENQUEUE_PAINT_REQUESTS
+	#endif
+	#define ILI9341_TILE_SIZE				8
+	#define ILI9341_TILE_COLUMNS			((LCD_SCREEN_WIDTH + ILI9341_TILE_SIZE - 1) / ILI9341_TILE_SIZE)
+	#define ILI9341_TILE_ROWS				((LCD_SCREEN_HEIGHT + ILI9341_TILE_SIZE - 1) / ILI9341_TILE_SIZE)
+	#define ILI9341_TILE_UNKNOWN			(0)
+	/*
+	// a hash of 0 means we don't know what's on the tile. The
+	// request being split into tiles is kept on tile_request
+	*/
+	static uint32_t tile_hash[ILI9341_TILE_ROWS][ILI9341_TILE_COLUMNS];
+	static ILI9341_PARTIAL_PAINT tile_request;
+	static unsigned char tile_column;
+	static unsigned char tiles_pending;
+	static uint32_t tiles_skipped;
+	/*
+	// the tiles of a row that overlap the request are rendered in
+	// order one row at a time into the band buffer and hashed as
+	// they go, so every pixel is rendered once and the rows are
+	// rendered in the order that the decoders of lglib expect
+	*/
+	static LG_RGB tile_band[ILI9341_TILE_SIZE][LCD_SCREEN_WIDTH];
+	static uint32_t tile_band_hash[ILI9341_TILE_COLUMNS];
+	static uint16_t tile_band_x;
+	static uint16_t tile_band_y;
+	static uint16_t tile_band_width;
+	static uint16_t tile_band_height;
+	static uint16_t tile_band_rows;
+#endif
+
+/*
+// macros for writing data and commands via spi
+*/
+#define LCD_WRITE_DATA(data)			ili9341_write(1, data)
+#define LCD_WRITE_CMD(cmd)				ili9341_write(0, cmd)
 
 #define LCD_WRITE_DATA_ASYNC(data)				\
 {											\
@@ -157,456 +340,1515 @@ static unsigned char delay_temp;
 }
 
 /*
-// macro for sending commands via spi
+// power on sequence
 */
-#define LCD_WRITE_CMD(cmd)					\
-{											\
-	for(delay_temp=0; delay_temp < 0x7f; delay_temp++);								\
-	ILI9341_ASSERT_CMD();					\
-	spi_write(SPI_GET_MODULE(2), cmd);		\
-}
+static const unsigned char init_sequence[] =
+{
+	ILI9341_SEQ_DELAY, 1,
+	ILI9341_SEQ_DEASSERT_RESET,
+	ILI9341_CMD_RESET, 0,
+	ILI9341_SEQ_DELAY, 5,
+	ILI9341_CMD_DISPLAY_OFF, 0,
+	ILI9341_CMD_POWER_ON_SEQ_CONTROL, 4, 0x64, 0x03, 0x12, 0x81,
+	ILI9341_CMD_DRIVER_TIMING_CONTROL_A, 3, 0x85, 0x00, 0x78,
+	ILI9341_CMD_DRIVER_TIMING_CONTROL_B, 2, 0x00, 0x00,
+	ILI9341_CMD_POWER_CONTROL_A, 5, 0x39, 0x2C, 0x00, 0x34, 0x02,
+	ILI9341_CMD_POWER_CONTROL_B, 3, 0x00, 0xC1, 0x30,
+	ILI9341_CMD_PUMP_RATIO_CONTROL, 1, 0x20,
+	ILI9341_CMD_POWER_CONTROL_1, 1, 0x09,			/* 3.3V */
+	ILI9341_CMD_POWER_CONTROL_2, 1, 0x01,			/* DDVDH = VCI*2 | VGH = VCI*7 | -VGL = VCI*3 */
+	ILI9341_CMD_VCOM_CONTROL_1, 2, 0x18, 0x64,		/* VCOMH = 3.3V | VCOML = 0V */
+	ILI9341_CMD_VCOM_CONTROL_2, 1, 0x9F,			/* VM = 1 | VCOMH = VMH | VCOML = VML  */
+	ILI9341_CMD_MEMORY_ACCESS_CONTROL, 1,			/* BGR/horizontal */
+		ILI9341_CMD_MEMORY_ACCESS_INVERT_COL_ORDER | 
+		ILI9341_CMD_MEMORY_ACCESS_INVERT_ROW_ORDER | 
+		ILI9341_CMD_MEMORY_ACCESS_HORIZONTAL | 
+		ILI9341_CMD_MEMORY_ACCESS_BGR,
+	ILI9341_CMD_COLMOD, 1, ILI9341_COLMOD_18BIT,
+	ILI9341_FRAME_RATE_CONTROL, 2, 0x00, 0x18,
+	ILI9341_DISPLAY_FUNCTION_CONTROL, 4, 0x0A, 0x82, 0x27, 0x00,
+	ILI9341_CMD_3GAMMA_ENABLE, 1, 0x00,
+	ILI9341_CMD_GAMMA_SET, 1, 0x01,
+	ILI9341_CMD_POSITIVE_GAMMA_CORRECTION, 15,
+		0x0F, 0x31, 0x2B, 0x0C, 0x0E, 0x08, 0x4E, 0xF1, 0x37, 0x07, 0x10, 0x03, 0x0E, 0x09, 0x00,
+	ILI9341_CMD_NEGATIVE_GAMMA_CORRECTION, 15,
+		0x00, 0x0E, 0x14, 0x03, 0x11, 0x07, 0x31, 0xC1, 0x48, 0x08, 0x0F, 0x0C, 0x31, 0x36, 0x0F,
+	ILI9341_CMD_3GAMMA_ENABLE, 1, 0x03,
+	ILI9341_CMD_BACKLIGHT_CONTROL_8, 1, 0x04,
+	ILI9341_CMD_WRITE_CTRL_DISPLAY, 1, 0x20,		/* brightness control */
+	ILI9341_CMD_WRITE_DISPLAY_BRIGHTNESS, 1, 0xFF,
+	ILI9341_SLEEP_OUT, 0,
+	ILI9341_SEQ_DELAY, 100,
+	/*
+	// set video ram pointer to pixel (0,0) and define screen dimensions
+	*/
+	ILI9341_COLUMN_ADDRESS_SET, 4, 0x00, 0x00, (LCD_SCREEN_WIDTH - 1) >> 8, (LCD_SCREEN_WIDTH - 1) & 0xFF,
+	ILI9341_PAGE_ADDRESS_SET, 4, 0x00, 0x00, (LCD_SCREEN_HEIGHT - 1) >> 8, (LCD_SCREEN_HEIGHT - 1) & 0xFF,
+	ILI9341_MEMORY_WRITE, 0,
+	ILI9341_SEQ_END
+};
 
+/*
+// turns the backlight off and enters sleep mode
+*/
+static const unsigned char sleep_sequence[] =
+{
+	ILI9341_CMD_WRITE_CTRL_DISPLAY, 1,
+		ILI9341_CTRL_DISPLAY_BRIGHTNESS_CONTROL_ON |
+		ILI9341_CTRL_DISPLAY_DIMMING_ON,
+	ILI9341_CMD_WRITE_DISPLAY_BRIGHTNESS, 1, 0x01,
+	ILI9341_CMD_DISPLAY_OFF, 0,
+	ILI9341_CMD_ENTER_SLEEP_MODE, 0,
+	ILI9341_SEQ_DELAY, 5,
+	ILI9341_SEQ_END
+};
 
 /*
-// prototypes
+// turns the backlight on and exits sleep mode
 */
-void ili9341_set_address(uint16_t x1, uint16_t y1, uint16_t x2,uint16_t y2);
+static const unsigned char wake_sequence[] =
+{
+	ILI9341_CMD_WRITE_CTRL_DISPLAY, 1,
+		ILI9341_CTRL_DISPLAY_BRIGHTNESS_CONTROL_ON |
+		ILI9341_CTRL_DISPLAY_DIMMING_ON | 
+		ILI9341_CTRL_DISPLAY_BACKLIGHT_ON,
+	ILI9341_SLEEP_OUT, 0,
+	ILI9341_SEQ_DELAY, 100,
+	ILI9341_CMD_DISPLAY_ON, 0,
+	ILI9341_SEQ_END
+};
 
 /*
-// send set address command
+// turns the display off and on without leaving sleep mode
 */
-void ili9341_set_address(uint16_t x1, uint16_t y1, uint16_t x2,uint16_t y2)
-{	
-	LCD_WRITE_CMD(ILI9341_COLUMN_ADDRESS_SET);
-	LCD_WRITE_DATA(x1 >> 8);
-	LCD_WRITE_DATA(x1);
-	LCD_WRITE_DATA(x2 >> 8);
-	LCD_WRITE_DATA(x2);
- 
-	LCD_WRITE_CMD(ILI9341_PAGE_ADDRESS_SET);
-	LCD_WRITE_DATA(y1 >> 8);
-	LCD_WRITE_DATA(y1);
-	LCD_WRITE_DATA(y2 >> 8);
-	LCD_WRITE_DATA(y2);    				 
-	LCD_WRITE_CMD(ILI9341_MEMORY_WRITE);
-}
+static const unsigned char display_off_sequence[] =
+{
+	ILI9341_CMD_DISPLAY_OFF, 0,
+	ILI9341_SEQ_END
+};
+
+static const unsigned char display_on_sequence[] =
+{
+	ILI9341_CMD_DISPLAY_ON, 0,
+	ILI9341_SEQ_END
+};
 
 /*
-// request a full screen paint
+// window setup sequence, the addresses are filled in by
+// ili9341_set_address
 */
-void ili9341_paint()
+static unsigned char window_sequence[] =
 {
-	if (!painting)
-	{
-		painting = 1;
-		x = 0;
-		y = 0;
-		x_end = LCD_SCREEN_WIDTH;
-		y_end = LCD_SCREEN_HEIGHT;
-		current_byte = 0;
-		ili9341_set_address(x, y, x_end - 1, y_end - 1);
-	}
-	else
-	{
-		#if defined(ILI9341_ENQUEUE_PAINT_REQUESTS)
-			_ASSERT(partial_paint[partial_paint_head].pending == 0);
-			partial_paint[partial_paint_head].x = 0;
-			partial_paint[partial_paint_head].y = 0;
-			partial_paint[partial_paint_head].width = LCD_SCREEN_WIDTH;
-			partial_paint[partial_paint_head].height = LCD_SCREEN_HEIGHT;
-			partial_paint[partial_paint_head].pending = 1;
-			partial_paint_head++;
-			//partial_paint_head &= (ILI9341_PARTIAL_PAINT_LIMIT - 1);
-			if (partial_paint_head == ILI9341_PARTIAL_PAINT_LIMIT)
-				partial_paint_head = 0;
-		#endif	
-	}	
-}
+	ILI9341_COLUMN_ADDRESS_SET, 4, 0x00, 0x00, 0x00, 0x00,
+	ILI9341_PAGE_ADDRESS_SET, 4, 0x00, 0x00, 0x00, 0x00,
+	ILI9341_MEMORY_WRITE, 0,
+	ILI9341_SEQ_END
+};
 
 /*
-// request a partial paint
+// scroll setup sequence, the area and start address are filled
+// in by ili9341_apply_scroll
 */
-void ili9341_paint_partial(int16_t x_pos, int16_t y_pos, int16_t width, int16_t height)
+static unsigned char scroll_sequence[] =
 {
-	if (painting)
+	ILI9341_CMD_VERTICAL_SCROLLING_DEFINITION, 6, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	ILI9341_CMD_VERTICAL_SCROLLING_START_ADDRESS, 2, 0x00, 0x00,
+	ILI9341_SEQ_END
+};
+
+#if defined(ILI9341_TRACE)
+
+/*
+// adds a record to the trace. Once a record doesn't fit the trace
+// ends there, smaller records that come after it are not added
+// so the trace never has holes in it
+*/
+static void ili9341_trace_record(unsigned char type, unsigned char size, uint16_t value)
+{
+	if (!trace_buffer || trace_full)
+		return;
+	if (trace_length + size > trace_size)
 	{
-		#if defined(ILI9341_ENQUEUE_PAINT_REQUESTS)
-			_ASSERT(partial_paint[partial_paint_head].pending == 0);
-			partial_paint[partial_paint_head].x = x_pos;
-			partial_paint[partial_paint_head].y = y_pos;
-			partial_paint[partial_paint_head].width = width;
-			partial_paint[partial_paint_head].height = height;
-			partial_paint[partial_paint_head].pending = 1;
-			partial_paint_head++;
-			//partial_paint_head &= (ILI9341_PARTIAL_PAINT_LIMIT - 1);
-			if (partial_paint_head == ILI9341_PARTIAL_PAINT_LIMIT)
-				partial_paint_head = 0;
-		#else
-			if ((x_pos < x_start || x_pos + width > x_end) ||
-				(y_pos < y_start || y_pos + height > y_end))			
-			{
-				x_start = x = MIN(x_start, x_pos);
-				y_start = y = MIN(y_start, y_pos);
-				x_end = MAX(x_end, x_pos + width);
-				y_end = MAX(y_end, y_pos + height);
-				/*
-				// set the partial area
-				*/
-				current_byte = 0;
-				ili9341_set_address(x, y, x_end - 1, y_end - 1);
-			}
-		#endif
+		trace_full = 1;
+		return;
 	}
-	else
+	trace_buffer[trace_length++] = type;
+	switch (type)
 	{
-		painting = 1;
-		x = x_pos;
-		y = y_pos;
-		x_start = x;
-		y_start = y;
-		x_end = x + width;
-		y_end = y + height;
-		/*
-		// set the partial area
-		*/
-		ili9341_set_address(x, y, x_end - 1, y_end - 1);
+		case ILI9341_TRACE_COMMAND:
+		case ILI9341_TRACE_DATA:
+			trace_buffer[trace_length++] = (unsigned char) value;
+			break;
+		case ILI9341_TRACE_PIXELS:
+			trace_buffer[trace_length++] = (unsigned char) value;
+			trace_buffer[trace_length++] = (unsigned char) (value >> 8);
+			break;
 	}
 }
 
 /*
-// turn display off
+// records the pixels sent since the last record
 */
-void ili9341_display_off(void)
+static void ili9341_trace_flush(void)
 {
-	LCD_WRITE_CMD(ILI9341_CMD_DISPLAY_OFF);
+	if (trace_pixels)
+	{
+		ili9341_trace_record(ILI9341_TRACE_PIXELS, 3, trace_pixels);
+		trace_pixels = 0;
+	}
 }
 
 /*
-// turn display on
+// counts pixels sent to the display
 */
-void ili9341_display_on(void)
+static void ili9341_trace_add_pixels(uint16_t pixels)
 {
-	LCD_WRITE_CMD(ILI9341_CMD_DISPLAY_ON);
+	if (trace_pixels > 0xFFFF - pixels)
+		ili9341_trace_flush();
+	trace_pixels += pixels;
+	trace_busy = 1;
 }
 
 /*
-// put lcd driver in sleep mode
+// starts recording the bytes sent to the display
 */
-void ili9341_sleep(void)
+void ili9341_trace_start(unsigned char* buffer, uint16_t size)
 {
-	/*
-	// turn backlight off
-	*/
-	LCD_WRITE_CMD(ILI9341_CMD_WRITE_CTRL_DISPLAY);
-	LCD_WRITE_DATA(
-		ILI9341_CTRL_DISPLAY_BRIGHTNESS_CONTROL_ON |
-		ILI9341_CTRL_DISPLAY_DIMMING_ON);
-
-	LCD_WRITE_CMD(ILI9341_CMD_WRITE_DISPLAY_BRIGHTNESS);
-	LCD_WRITE_DATA(0x01)
-	//LCD_WRITE_CMD(ILI9341_CMD_BACKLIGHT_CONTROL_8);
-	//LCD_WRITE_DATA(ILI9341_BACKLIGHT_CONTROL_8_LEDOFF);
-	/*
-	// enter sleep mode
-	*/
-	LCD_WRITE_CMD(ILI9341_CMD_DISPLAY_OFF);
-	LCD_WRITE_CMD(ILI9341_CMD_ENTER_SLEEP_MODE); 
-	rtc_sleep(5);
+	trace_buffer = buffer;
+	trace_size = size;
+	trace_length = 0;
+	trace_pixels = 0;
+	trace_busy = 0;
+	trace_full = 0;
 }
 
 /*
-// wake up from sleep
+// stops recording and returns the length of the trace
 */
-void ili9341_wake(void)
+uint16_t ili9341_trace_stop(void)
 {
-	/*
-	// turn backlight on
-	*/
-	LCD_WRITE_CMD(ILI9341_CMD_WRITE_CTRL_DISPLAY);
-	LCD_WRITE_DATA(
-		ILI9341_CTRL_DISPLAY_BRIGHTNESS_CONTROL_ON |
-		ILI9341_CTRL_DISPLAY_DIMMING_ON | 
-		ILI9341_CTRL_DISPLAY_BACKLIGHT_ON);
-
-	//LCD_WRITE_CMD(ILI9341_CMD_WRITE_DISPLAY_BRIGHTNESS);
-	//LCD_WRITE_DATA(0xFF)
-	//LCD_WRITE_CMD(ILI9341_CMD_BACKLIGHT_CONTROL_8);
-	//LCD_WRITE_DATA(ILI9341_BACKLIGHT_CONTROL_8_LEDON);
-	/*
-	// exit sleep mode
-	*/
-	LCD_WRITE_CMD(ILI9341_SLEEP_OUT); 
-	rtc_sleep(100);
-	LCD_WRITE_CMD(ILI9341_CMD_DISPLAY_ON);
+	ili9341_trace_flush();
+	trace_buffer = NULL;
+	return trace_length;
 }
 
-
-char ili9341_is_painting()
+/*
+// gets the area two windows have in common
+*/
+static uint32_t ili9341_trace_overlap(const uint16_t* a, const uint16_t* b)
 {
-	return painting;
+	uint16_t x1 = MAX(a[0], b[0]);
+	uint16_t x2 = MIN(a[1], b[1]);
+	uint16_t y1 = MAX(a[2], b[2]);
+	uint16_t y2 = MIN(a[3], b[3]);
+	
+	if (x1 > x2 || y1 > y2)
+		return 0;
+	return (uint32_t) (x2 - x1 + 1) * (y2 - y1 + 1);
 }
 
 /*
-// performs the painting in the "background"
-// must be called from application loop
+// analyzes a trace. The clock is the spi clock in Hz and is used
+// to estimate the time the bytes took on the bus. Overdraw is
+// estimated from the windows painted on each frame. Returns 0
+// if the trace is not valid
 */
-void ili9341_do_processing()
+char ili9341_trace_analyze(const unsigned char* trace, uint16_t length, uint32_t clock, ILI9341_TRACE_STATS* stats)
 {
-	static char pixel_fetched = 0;
-	static uint32_t pixel_color;
-		
-	if (painting)
+	uint16_t i = 0;
+	uint16_t value;
+	uint16_t address[2] = { 0, 0 };
+	uint16_t window[4] = { 0, 0, 0, 0 };
+	uint16_t frame[ILI9341_TRACE_MAX_WINDOWS][4];
+	unsigned char frame_windows = 0;
+	unsigned char command = 0;
+	unsigned char param = 0;
+	unsigned char window_valid[2] = { 0, 0 };
+	char window_painted = 1;
+	uint32_t overdraw;
+	uint32_t* bytes = &stats->other_bytes;
+	unsigned char j;
+	
+	memset(stats, 0, sizeof(ILI9341_TRACE_STATS));
+	
+	while (i < length)
 	{
-		/*
-		// get pixel from graphics library
-		*/
-		if (!pixel_fetched)
-		{
-			pixel_color = ILI9341_GET_PIXEL(x, y);
-			pixel_color &= 0x7e7e7e;
-			pixel_fetched = 1;
-		}
-		/*
-		// if the spi is busy return
-		*/
-		if (!spi_ready(SPI_GET_MODULE(2)))
-			return;
-		/*
-		// send pixel to LCD driver
-		*/
-		switch (current_byte)
+		switch (trace[i])
 		{
-			case 0:
-				LCD_WRITE_DATA_ASYNC(((unsigned char*) &pixel_color)[2]);
-				current_byte = 1;
-				break;
-			case 1:			
-				LCD_WRITE_DATA_ASYNC(((unsigned char*) &pixel_color)[1]);
-				current_byte = 2;
+			case ILI9341_TRACE_COMMAND:
+				if (i + 2 > length)
+					return 0;
+				command = trace[i + 1];
+				param = 0;
+				switch (command)
+				{
+					case ILI9341_COLUMN_ADDRESS_SET:
+					case ILI9341_PAGE_ADDRESS_SET:
+						bytes = &stats->window_bytes;
+						break;
+					case ILI9341_MEMORY_WRITE:
+						bytes = &stats->window_bytes;
+						stats->windows++;
+						window_painted = 0;
+						break;
+					case ILI9341_CMD_VERTICAL_SCROLLING_DEFINITION:
+					case ILI9341_CMD_VERTICAL_SCROLLING_START_ADDRESS:
+						bytes = &stats->scroll_bytes;
+						break;
+					default:
+						bytes = &stats->other_bytes;
+						break;
+				}
+				(*bytes)++;
+				i += 2;
 				break;
-			case 2:
-				LCD_WRITE_DATA_ASYNC(((unsigned char*) &pixel_color)[0]);
-				current_byte = 0;
-				pixel_fetched = 0;
-				
-				x++;
-				if (x >= x_end) 
+			
+			case ILI9341_TRACE_DATA:
+				if (i + 2 > length)
+					return 0;
+				(*bytes)++;
+				/*
+				// collect the addresses of the window
+				*/
+				if ((command == ILI9341_COLUMN_ADDRESS_SET || command == ILI9341_PAGE_ADDRESS_SET) && param < 4)
 				{
-					x = x_start;
-					y++;
-					if (y >= y_end)
+					if (param & 1)
+						address[param >> 1] |= trace[i + 1];
+					else
+						address[param >> 1] = (uint16_t) trace[i + 1] << 8;
+					if (++param == 4)
 					{
-						while (!SPI2STATbits.SPIRBF);
-						painting = SPI2BUF;
-						painting = 0;
+						j = (command == ILI9341_COLUMN_ADDRESS_SET) ? 0 : 2;
+						if (window_valid[j >> 1] && window[j] == address[0] && window[j + 1] == address[1])
+							stats->redundant_windows++;
+						window[j] = address[0];
+						window[j + 1] = address[1];
+						window_valid[j >> 1] = 1;
 					}
 				}
+				i += 2;
 				break;
+			
+			case ILI9341_TRACE_PIXELS:
+				if (i + 3 > length)
+					return 0;
+				value = trace[i + 1] | ((uint16_t) trace[i + 2] << 8);
+				stats->pixels += value;
+				stats->pixel_bytes += (uint32_t) value * 3;
+				/*
+				// the first time pixels are sent to a window it's
+				// compared to the ones painted before on the frame
+				*/
+				if (!window_painted)
+				{
+					window_painted = 1;
+					overdraw = 0;
+					for (j = 0; j < frame_windows; j++)
+						overdraw += ili9341_trace_overlap(frame[j], window);
+					stats->overdraw += MIN(overdraw, (uint32_t) (window[1] - window[0] + 1) * (window[3] - window[2] + 1));
+					if (frame_windows < ILI9341_TRACE_MAX_WINDOWS)
+						memcpy(frame[frame_windows++], window, sizeof(window));
+				}
+				i += 3;
+				break;
+			
+			case ILI9341_TRACE_IDLE:
+				stats->frames++;
+				frame_windows = 0;
+				i++;
+				break;
+			
+			default:
+				return 0;
 		}
 	}
-	else
+	
+	if (clock >= 1000000UL)
 	{
-		#if defined(ILI9341_ENQUEUE_PAINT_REQUESTS)
-		if (partial_paint[partial_paint_index].pending)
-		{
-			ili9341_paint_partial
-			(
-				partial_paint[partial_paint_index].x,
-				partial_paint[partial_paint_index].y,
-				partial_paint[partial_paint_index].width,
-				partial_paint[partial_paint_index].height
-			);
-			partial_paint[partial_paint_index].pending = 0;
-			partial_paint_index++;
-			//partial_paint_index &= ILI9341_PARTIAL_PAINT_LIMIT - 1;	
-			if (partial_paint_index == ILI9341_PARTIAL_PAINT_LIMIT)
-				partial_paint_index = 0;
-		}
-		#endif	
+		stats->bus_time = ((stats->window_bytes + stats->scroll_bytes + 
+			stats->other_bytes + stats->pixel_bytes) * 8) / (clock / 1000000UL);
 	}
+	return 1;
 }
 
-
-void ili9341_init()
+/*
+// adds count times the given nanoseconds to a time kept in microseconds
+// and the nanoseconds left over. A frame of a few seconds would overflow
+// a count of nanoseconds
+*/
+static void ili9341_trace_add_time(uint32_t* time, uint16_t* ns, uint32_t count, uint32_t each)
 {
-	/*
-	// initialize IO pins
-	*/
-	ILI9341_IO_INIT();
-	/*
-	// initialize spi module
-	*/
-	spi_init(SPI_GET_MODULE(2));
-	spi_set_clock(SPI_GET_MODULE(2), 9000000L);
-	/*
-	// reset
-	*/
-	ILI9341_ASSERT_RESET();
-	rtc_sleep(1);
-	ILI9341_DEASSERT_RESET();	
-	/*
-	// assert chip-select line
-	*/
-	ILI9341_ASSERT_CS();
-	/*
-	// send software reset command
-	*/
-	LCD_WRITE_CMD(ILI9341_CMD_RESET);
-	rtc_sleep(5);
-	LCD_WRITE_CMD(ILI9341_CMD_DISPLAY_OFF);
-	/*
-	// set power on seq control register
-	*/
-	LCD_WRITE_CMD(ILI9341_CMD_POWER_ON_SEQ_CONTROL);  
-	LCD_WRITE_DATA(0x64); 
-	LCD_WRITE_DATA(0x03); 
-	LCD_WRITE_DATA(0X12); 
-	LCD_WRITE_DATA(0X81); 
-	/*
-	// set timing control registers
-	*/	
-	LCD_WRITE_CMD(ILI9341_CMD_DRIVER_TIMING_CONTROL_A);  
-	LCD_WRITE_DATA(0x85); 
-	LCD_WRITE_DATA(0x00); 
-	LCD_WRITE_DATA(0x78); 
-	
-	LCD_WRITE_CMD(ILI9341_CMD_DRIVER_TIMING_CONTROL_B);  
-	LCD_WRITE_DATA(0x00); 
-	LCD_WRITE_DATA(0x00); 
-	/*
-	// initialize power control registers
-	*/
-	LCD_WRITE_CMD(ILI9341_CMD_POWER_CONTROL_A);  
-	LCD_WRITE_DATA(0x39); 
-	LCD_WRITE_DATA(0x2C); 
-	LCD_WRITE_DATA(0x00); 
-	LCD_WRITE_DATA(0x34); 
-	LCD_WRITE_DATA(0x02); 
-	
-	LCD_WRITE_CMD(ILI9341_CMD_POWER_CONTROL_B);  
-	LCD_WRITE_DATA(0x00); 
-	LCD_WRITE_DATA(0XC1); 
-	LCD_WRITE_DATA(0X30); 
+	uint32_t rest;
 	
-	LCD_WRITE_CMD(ILI9341_CMD_PUMP_RATIO_CONTROL);
-	LCD_WRITE_DATA(0x20); 
-	
-	LCD_WRITE_CMD(ILI9341_CMD_POWER_CONTROL_1);
-	LCD_WRITE_DATA(0x09);	/* 3.3V */
+	rest = *ns + count * (each % 1000);
+	*time += count * (each / 1000) + rest / 1000;
+	*ns = rest % 1000;
+}
+
+/*
+// adds a frame to an estimate, the times are in microseconds
+*/
+static void ili9341_trace_end_frame(ILI9341_TRACE_ESTIMATE* estimate, 
+	const ILI9341_COST_MODEL* model, uint32_t transfer, uint32_t render)
+{
+	uint32_t frame;
 	
-	LCD_WRITE_CMD(ILI9341_CMD_POWER_CONTROL_2);
-	LCD_WRITE_DATA(0x01);	/* DDVDH = VCI*2 | VGH = VCI*7 | -VGL = VCI*3 */
+	if (model->overlapped)
+		frame = MAX(transfer, render);
+	else
+		frame = transfer + render;
+	estimate->total_time += frame;
+	estimate->worst_frame_time = MAX(estimate->worst_frame_time, frame);
+	estimate->frames++;
+}
+
+/*
+// predicts how long each frame of a trace takes on the target from
+// the bytes sent, the switches between commands and data and the
+// pixels rendered. Returns 0 if the trace is not valid
+*/
+char ili9341_trace_estimate(const unsigned char* trace, uint16_t length, 
+	const ILI9341_COST_MODEL* model, ILI9341_TRACE_ESTIMATE* estimate)
+{
+	uint16_t i = 0;
+	uint16_t pixels;
+	uint32_t byte_time;
+	uint32_t transfer = 0;
+	uint32_t render = 0;
+	uint16_t transfer_ns = 0;
+	uint16_t render_ns = 0;
+	char data = 0;
 	
-	LCD_WRITE_CMD(ILI9341_CMD_VCOM_CONTROL_1);
-	LCD_WRITE_DATA(0x18);	/* VCOMH = 3.3V */
-	LCD_WRITE_DATA(0x64); 	/* VCOML = 0V */
+	memset(estimate, 0, sizeof(ILI9341_TRACE_ESTIMATE));
+	if (model->clock < 1000UL)
+		return 0;
+	byte_time = 8000000UL / (model->clock / 1000UL) + model->byte_overhead;
 	
-	LCD_WRITE_CMD(ILI9341_CMD_VCOM_CONTROL_2);
-	LCD_WRITE_DATA(0x9F);	/* VM = 1 | VCOMH = VMH | VCOML = VML  */
-	/*
-	// set video memory format to BGR/horizontal
-	*/
-	LCD_WRITE_CMD(ILI9341_CMD_MEMORY_ACCESS_CONTROL);
-	LCD_WRITE_DATA(	
-		ILI9341_CMD_MEMORY_ACCESS_INVERT_COL_ORDER | 
-		ILI9341_CMD_MEMORY_ACCESS_INVERT_ROW_ORDER | 
-		ILI9341_CMD_MEMORY_ACCESS_HORIZONTAL | 
-		ILI9341_CMD_MEMORY_ACCESS_BGR);
-	/*
-	// set color mode to 18-bit
-	*/
-	LCD_WRITE_CMD(ILI9341_CMD_COLMOD);    
-	LCD_WRITE_DATA(ILI9341_COLMOD_18BIT); 
-	/*
-	// set frame rate control
-	*/	
-	LCD_WRITE_CMD(ILI9341_FRAME_RATE_CONTROL);
-	LCD_WRITE_DATA(0x00);  
-	LCD_WRITE_DATA(0x18); 
-	/*
-	// set display function register
-	*/
-	LCD_WRITE_CMD(ILI9341_DISPLAY_FUNCTION_CONTROL);
-	LCD_WRITE_DATA(0x0A); 
-	LCD_WRITE_DATA(0x82);
-	LCD_WRITE_DATA(0x27);  
-	LCD_WRITE_DATA(0x00);
-	/*
-	// disable 3Gamma
-	*/
-	LCD_WRITE_CMD(ILI9341_CMD_3GAMMA_ENABLE);
-	LCD_WRITE_DATA(0x00); 
-	
-	LCD_WRITE_CMD(ILI9341_CMD_GAMMA_SET);    //Gamma curve selected 
-	LCD_WRITE_DATA(0x01); 
-	
-	LCD_WRITE_CMD(ILI9341_CMD_POSITIVE_GAMMA_CORRECTION);
-	LCD_WRITE_DATA(0x0F); 
-	LCD_WRITE_DATA(0x31); 
-	LCD_WRITE_DATA(0x2B); 
-	LCD_WRITE_DATA(0x0C); 
-	LCD_WRITE_DATA(0x0E); 
-	LCD_WRITE_DATA(0x08); 
-	LCD_WRITE_DATA(0x4E); 
-	LCD_WRITE_DATA(0xF1); 
-	LCD_WRITE_DATA(0x37); 
-	LCD_WRITE_DATA(0x07); 
-	LCD_WRITE_DATA(0x10); 
-	LCD_WRITE_DATA(0x03); 
-	LCD_WRITE_DATA(0x0E); 
-	LCD_WRITE_DATA(0x09); 
-	LCD_WRITE_DATA(0x00); 
-	
-	LCD_WRITE_CMD(ILI9341_CMD_NEGATIVE_GAMMA_CORRECTION);
-	LCD_WRITE_DATA(0x00); 
-	LCD_WRITE_DATA(0x0E); 
-	LCD_WRITE_DATA(0x14); 
-	LCD_WRITE_DATA(0x03); 
-	LCD_WRITE_DATA(0x11); 
-	LCD_WRITE_DATA(0x07); 
-	LCD_WRITE_DATA(0x31); 
-	LCD_WRITE_DATA(0xC1); 
-	LCD_WRITE_DATA(0x48); 
-	LCD_WRITE_DATA(0x08); 
-	LCD_WRITE_DATA(0x0F); 
-	LCD_WRITE_DATA(0x0C); 
-	LCD_WRITE_DATA(0x31); 
-	LCD_WRITE_DATA(0x36); 
-	LCD_WRITE_DATA(0x0F); 
+	while (i < length)
+	{
+		switch (trace[i])
+		{
+			case ILI9341_TRACE_COMMAND:
+				if (i + 2 > length)
+					return 0;
+				if (data)
+					ili9341_trace_add_time(&transfer, &transfer_ns, 1, model->dc_toggle);
+				ili9341_trace_add_time(&transfer, &transfer_ns, 1, byte_time);
+				data = 0;
+				i += 2;
+				break;
+			
+			case ILI9341_TRACE_DATA:
+				if (i + 2 > length)
+					return 0;
+				if (!data)
+					ili9341_trace_add_time(&transfer, &transfer_ns, 1, model->dc_toggle);
+				ili9341_trace_add_time(&transfer, &transfer_ns, 1, byte_time);
+				data = 1;
+				i += 2;
+				break;
+			
+			case ILI9341_TRACE_PIXELS:
+				if (i + 3 > length)
+					return 0;
+				pixels = trace[i + 1] | ((uint16_t) trace[i + 2] << 8);
+				if (!data)
+					ili9341_trace_add_time(&transfer, &transfer_ns, 1, model->dc_toggle);
+				ili9341_trace_add_time(&transfer, &transfer_ns, (uint32_t) pixels * 3, byte_time);
+				ili9341_trace_add_time(&render, &render_ns, pixels, model->pixel_render);
+				data = 1;
+				i += 3;
+				break;
+			
+			case ILI9341_TRACE_IDLE:
+				ili9341_trace_end_frame(estimate, model, transfer, render);
+				transfer = 0;
+				render = 0;
+				transfer_ns = 0;
+				render_ns = 0;
+				i++;
+				break;
+			
+			default:
+				return 0;
+		}
+	}
 	/*
-	// disable 3G
+	// a trace stopped in the middle of a frame
 	*/
-	LCD_WRITE_CMD(ILI9341_CMD_3GAMMA_ENABLE);
-	LCD_WRITE_DATA(0x03);
-	/*
-	// set backlight control registers
-	*/ 
-	LCD_WRITE_CMD(ILI9341_CMD_BACKLIGHT_CONTROL_8);
-	LCD_WRITE_DATA(0x04);
+	if (transfer || render || transfer_ns || render_ns)
+		ili9341_trace_end_frame(estimate, model, transfer, render);
+	
+	if (estimate->frames)
+	{
+		estimate->average_frame_time = estimate->total_time / estimate->frames;
+		if (estimate->average_frame_time)
+			estimate->fps = (uint16_t) MIN(1000000UL / estimate->average_frame_time, 0xFFFF);
+	}
+	return 1;
+}
 
+#endif
+
+/*
+// waits for the last byte written by ili9341_write to be shifted
+// out and clears the receive buffer
+*/
+static void ili9341_wait_spi(void)
+{
+	if (spi_busy)
+	{
+		while (!SPI2STATbits.SPIRBF);
+		spi_busy = SPI2BUF;
+		spi_busy = 0;
+	}
+}
+
+/*
+// writes a command or data byte. The D/C line must not change
+// while a byte is being shifted out so we wait for the previous
+// one to complete instead of using a fixed delay
+*/
+static void ili9341_write(char data, unsigned char value)
+{
+	#if defined(ILI9341_TRACE)
+		if (data)
+		{
+			ili9341_trace_record(ILI9341_TRACE_DATA, 2, value);
+		}
+		else
+		{
+			ili9341_trace_flush();
+			ili9341_trace_record(ILI9341_TRACE_COMMAND, 2, value);
+		}
+	#endif
+	ili9341_wait_spi();
+	if (data)
+	{
+		ILI9341_ASSERT_DATA();
+	}
+	else
+	{
+		ILI9341_ASSERT_CMD();
+	}
+	spi_write_async(SPI_GET_MODULE(2), value);
+	spi_busy = 1;
+}
+
+/*
+// sends an entry of a command sequence as a single burst and
+// returns the next one. Delays are timed by ili9341_sequence_step
+// so the sequences sent with ili9341_send_sequence can't have them
+*/
+static const unsigned char* ili9341_send_entry(const unsigned char* entry)
+{
+	unsigned char argc;
+	
+	switch (*entry)
+	{
+		case ILI9341_SEQ_DEASSERT_RESET:
+			ILI9341_DEASSERT_RESET();
+			return entry + 1;
+		
+		default:
+			LCD_WRITE_CMD(entry[0]);
+			argc = entry[1];
+			entry += 2;
+			while (argc--)
+				LCD_WRITE_DATA(*entry++);
+			return entry;
+	}
+}
+
+/*
+// sends a whole command sequence and waits for it to complete
+*/
+static void ili9341_send_sequence(const unsigned char* sequence)
+{
+	while (*sequence != ILI9341_SEQ_END)
+		sequence = ili9341_send_entry(sequence);
+	ili9341_wait_spi();
+}
+
+/*
+// starts a command sequence. If one is already running the
+// new one starts when it's done
+*/
+static void ili9341_start_sequence(const unsigned char* sequence)
+{
+	if (seq)
+		seq_next = sequence;
+	else
+		seq = sequence;
+}
+
+/*
+// runs the next entry of the command sequence. Returns -1
+// while waiting for a delay to elapse
+*/
+static int16_t ili9341_sequence_step(void)
+{
+	if (seq_delay)
+	{
+		/*
+		// the delay may start just before a tick so it's counted
+		// from the next one, the delays are panel minimums
+		*/
+		if ((uint32_t) (ILI9341_GET_TICKS() - seq_delay_start) <= seq_delay)
+			return -1;
+		seq_delay = 0;
+	}
+	switch (*seq)
+	{
+		case ILI9341_SEQ_END:
+			ili9341_wait_spi();
+			seq = seq_next;
+			seq_next = NULL;
+			break;
+		
+		case ILI9341_SEQ_DELAY:
+			seq_delay = seq[1];
+			seq_delay_start = ILI9341_GET_TICKS();
+			seq += 2;
+			break;
+		
+		default:
+			seq = ili9341_send_entry(seq);
+			break;
+	}
+	return 0;
+}
+
+/*
+// prototypes
+*/
+void ili9341_set_address(uint16_t x1, uint16_t y1, uint16_t x2,uint16_t y2);
+
+/*
+// send set address command
+*/
+void ili9341_set_address(uint16_t x1, uint16_t y1, uint16_t x2,uint16_t y2)
+{	
 	/*
-	// enable brightness control
-	*/
-	LCD_WRITE_CMD(ILI9341_CMD_WRITE_CTRL_DISPLAY);
-	LCD_WRITE_DATA(0x20);
-		/*ILI9341_CTRL_DISPLAY_BRIGHTNESS_CONTROL_ON |
-		ILI9341_CTRL_DISPLAY_DIMMING_ON | 
-		ILI9341_CTRL_DISPLAY_BACKLIGHT_ON);*/
-	/*
-	// set display brightness
+	// the column and page addresses are only sent if
+	// they changed since the last time
 	*/
-	LCD_WRITE_CMD(ILI9341_CMD_WRITE_DISPLAY_BRIGHTNESS);
-	LCD_WRITE_DATA(0xFF)
+	if (!window_valid || x1 != window_x1 || x2 != window_x2)
+	{
+		window_sequence[2] = x1 >> 8;
+		window_sequence[3] = x1;
+		window_sequence[4] = x2 >> 8;
+		window_sequence[5] = x2;
+		ili9341_send_entry(&window_sequence[0]);
+		window_x1 = x1;
+		window_x2 = x2;
+	}
+	else
+	{
+		bytes_saved += 5;
+	}
+	if (!window_valid || y1 != window_y1 || y2 != window_y2)
+	{
+		window_sequence[8] = y1 >> 8;
+		window_sequence[9] = y1;
+		window_sequence[10] = y2 >> 8;
+		window_sequence[11] = y2;
+		ili9341_send_entry(&window_sequence[6]);
+		window_y1 = y1;
+		window_y2 = y2;
+	}
+	else
+	{
+		bytes_saved += 5;
+	}
+	window_valid = 1;
+	ili9341_send_sequence(&window_sequence[12]);
+}
+
+/*
+// gets the number of command bytes that were not sent
+// because the address window didn't change
+*/
+uint32_t ili9341_get_bytes_saved(void)
+{
+	return bytes_saved;
+}
+
+#if defined(ILI9341_TILE_HASHING)
+
+/*
+// adds a row of pixels to a tile hash. The hash is FNV-1a over
+// the bits of the pixels that are sent to the display
+*/
+static uint32_t ili9341_hash_span(uint32_t hash, const LG_RGB* pixels, uint16_t width)
+{
+	uint16_t i;
+	for (i = 0; i < width; i++)
+		hash = (hash ^ (pixels[i] & 0x7E7E7E)) * 16777619UL;
+	return hash;
+}
+
+/*
+// forgets what's on the tiles that overlap a range of columns
+*/
+static void ili9341_forget_tiles(uint16_t x_pos, uint16_t width)
+{
+	unsigned char row;
+	unsigned char column;
+	
+	if (!width)
+		return;
+	for (row = 0; row < ILI9341_TILE_ROWS; row++)
+	{
+		for (column = x_pos / ILI9341_TILE_SIZE; column <= (x_pos + width - 1) / ILI9341_TILE_SIZE; column++)
+			tile_hash[row][column] = ILI9341_TILE_UNKNOWN;
+	}
+}
+
+#endif
+
+/*
+// sends the scroll area and offset requested since the
+// last time to the display
+*/
+static void ili9341_apply_scroll(void)
+{
+	uint16_t top;
+	uint16_t start;
+	uint16_t bottom;
+	
+	#if defined(ILI9341_TILE_HASHING)
+		/*
+		// the contents of the old and new scroll areas move
+		// on the display
+		*/
+		ili9341_forget_tiles(scroll_x, scroll_width);
+		ili9341_forget_tiles(scroll_next_x, scroll_next_width);
+	#endif
+	scroll_x = scroll_next_x;
+	scroll_width = scroll_next_width;
+	scroll_offset = scroll_next_offset;
+	scroll_pending = 0;
+	
+	if (!scroll_width)
+	{
+		top = 0;
+		bottom = 0;
+		start = 0;
+	}
+	else
+	{
+		#if defined(ILI9341_SCROLL_REVERSED)
+			top = LCD_SCREEN_WIDTH - scroll_x - scroll_width;
+			start = top + (scroll_offset ? scroll_width - scroll_offset : 0);
+		#else
+			top = scroll_x;
+			start = top + scroll_offset;
+		#endif
+		bottom = LCD_SCREEN_WIDTH - top - scroll_width;
+	}
+	scroll_sequence[2] = top >> 8;
+	scroll_sequence[3] = top;
+	scroll_sequence[4] = (LCD_SCREEN_WIDTH - top - bottom) >> 8;
+	scroll_sequence[5] = LCD_SCREEN_WIDTH - top - bottom;
+	scroll_sequence[6] = bottom >> 8;
+	scroll_sequence[7] = bottom;
+	scroll_sequence[10] = start >> 8;
+	scroll_sequence[11] = start;
+	ili9341_send_sequence(scroll_sequence);
+}
+
+/*
+// maps a range of screen columns to display memory. Returns the
+// number of columns that are contiguous in display memory and the
+// memory column of the first one
+*/
+static uint16_t ili9341_map_columns(uint16_t x_pos, uint16_t width, uint16_t* column)
+{
+	uint16_t offset;
+	
+	*column = x_pos;
+	if (!scroll_width || x_pos >= scroll_x + scroll_width)
+		return width;
+	if (x_pos < scroll_x)
+		return MIN(width, scroll_x - x_pos);
+	
+	offset = x_pos - scroll_x + scroll_offset;
+	if (offset >= scroll_width)
+		offset -= scroll_width;
+	*column = scroll_x + offset;
+	return MIN(MIN(width, scroll_width - offset), scroll_x + scroll_width - x_pos);
+}
+
+/*
+// starts painting a region. If parts of the region are not
+// contiguous in display memory because of scrolling the first
+// part is painted now and the rest when it's done
+*/
+static void ili9341_start_paint(uint16_t x_pos, uint16_t y_pos, uint16_t width, uint16_t height)
+{
+	uint16_t n;
+	uint16_t column;
+	
+	if (scroll_pending && !split_width)
+		ili9341_apply_scroll();
+	
+	n = ili9341_map_columns(x_pos, width, &column);
+	split_x = x_pos + n;
+	split_y = y_pos;
+	split_width = width - n;
+	split_height = height;
+	
+	painting = 1;
+	x = x_pos;
+	y = y_pos;
+	x_start = x;
+	y_start = y;
+	x_end = x + n;
+	y_end = y + height;
+	current_byte = 0;
 	/*
-	// exit sleep mode
+	// set the partial area
 	*/
-	LCD_WRITE_CMD(ILI9341_SLEEP_OUT); 
-	rtc_sleep(100);
+	ili9341_set_address(column, y, column + n - 1, y_end - 1);
+}
+
+#if defined(ILI9341_TILE_HASHING)
+
+/*
+// starts rendering the band of tiles that starts on the given row
+*/
+static void ili9341_start_band(uint16_t y_pos)
+{
+	unsigned char column;
+	
+	tile_band_y = y_pos;
+	tile_band_height = MIN(ILI9341_TILE_SIZE, LCD_SCREEN_HEIGHT - y_pos);
+	tile_band_rows = 0;
+	tile_column = tile_band_x / ILI9341_TILE_SIZE;
+	for (column = tile_column; column < tile_column + tile_band_width / ILI9341_TILE_SIZE; column++)
+		tile_band_hash[column] = 2166136261UL;
+}
+
+/*
+// starts painting a region one band of tiles at a time. The bands
+// cover the whole tiles that overlap the region
+*/
+static void ili9341_start_tiles(uint16_t x_pos, uint16_t y_pos, uint16_t width, uint16_t height)
+{
+	if (x_pos >= LCD_SCREEN_WIDTH || y_pos >= LCD_SCREEN_HEIGHT || !width || !height)
+		return;
+	tile_request.x = x_pos;
+	tile_request.y = y_pos;
+	tile_request.width = MIN(width, LCD_SCREEN_WIDTH - x_pos);
+	tile_request.height = MIN(height, LCD_SCREEN_HEIGHT - y_pos);
+	tile_band_x = x_pos - x_pos % ILI9341_TILE_SIZE;
+	tile_band_width = MIN(tile_request.x + tile_request.width + ILI9341_TILE_SIZE - 1 - tile_band_x, 
+		LCD_SCREEN_WIDTH - tile_band_x);
+	tile_band_width -= tile_band_width % ILI9341_TILE_SIZE;
+	ili9341_start_band(y_pos - y_pos % ILI9341_TILE_SIZE);
+	tiles_pending = 1;
+}
+
+/*
+// renders the next row of the band and adds it to the hashes of
+// it's tiles. Once the band is rendered each tile is compared to
+// what the display shows and painted from the band if it changed.
+// If the region covers at least half of the tile the whole tile is
+// painted, otherwise only the region is and we forget what's on the
+// tile. Returns 0
+*/
+static int16_t ili9341_tile_step(void)
+{
+	unsigned char column;
+	uint16_t x_pos;
+	uint16_t width;
+	uint16_t x1;
+	uint16_t y1;
+	uint16_t x2;
+	uint16_t y2;
+	uint32_t hash;
+	
+	if (tile_band_rows < tile_band_height)
+	{
+		ILI9341_GET_SPAN(tile_band_x, tile_band_y + tile_band_rows, tile_band_width, tile_band[tile_band_rows]);
+		for (column = 0; column < tile_band_width / ILI9341_TILE_SIZE; column++)
+		{
+			tile_band_hash[tile_band_x / ILI9341_TILE_SIZE + column] = ili9341_hash_span(
+				tile_band_hash[tile_band_x / ILI9341_TILE_SIZE + column], 
+				&tile_band[tile_band_rows][column * ILI9341_TILE_SIZE], ILI9341_TILE_SIZE);
+		}
+		tile_band_rows++;
+		return 0;
+	}
+	
+	x_pos = (uint16_t) tile_column * ILI9341_TILE_SIZE;
+	if (x_pos < tile_band_x + tile_band_width)
+	{
+		width = ILI9341_TILE_SIZE;
+		x1 = MAX(x_pos, tile_request.x);
+		y1 = MAX(tile_band_y, tile_request.y);
+		x2 = MIN(x_pos + width, tile_request.x + tile_request.width);
+		y2 = MIN(tile_band_y + tile_band_height, tile_request.y + tile_request.height);
+		hash = tile_band_hash[tile_column];
+		if (hash == ILI9341_TILE_UNKNOWN)
+			hash = 1;
+		
+		if (hash == tile_hash[tile_band_y / ILI9341_TILE_SIZE][tile_column])
+		{
+			tiles_skipped++;
+		}
+		else if ((uint32_t) (x2 - x1) * (y2 - y1) * 2 >= (uint32_t) width * tile_band_height)
+		{
+			tile_hash[tile_band_y / ILI9341_TILE_SIZE][tile_column] = hash;
+			ili9341_start_paint(x_pos, tile_band_y, width, tile_band_height);
+		}
+		else
+		{
+			tile_hash[tile_band_y / ILI9341_TILE_SIZE][tile_column] = ILI9341_TILE_UNKNOWN;
+			ili9341_start_paint(x1, y1, x2 - x1, y2 - y1);
+		}
+		tile_column++;
+		return 0;
+	}
 	/*
-	// set video ram pointer to pixel (0,0) and define screen dimensions
+	// move on to the next band once the last tile is sent
 	*/
-	ili9341_set_address(0, 0, LCD_SCREEN_WIDTH - 1, LCD_SCREEN_HEIGHT - 1);
-	LCD_WRITE_CMD(ILI9341_MEMORY_WRITE);
+	if (tile_band_y + tile_band_height < tile_request.y + tile_request.height)
+		ili9341_start_band(tile_band_y + tile_band_height);
+	else
+		tiles_pending = 0;
+	return 0;
+}
+
+/*
+// gets the number of tiles that were not sent because
+// the display already showed them
+*/
+uint32_t ili9341_get_tiles_skipped(void)
+{
+	return tiles_skipped;
+}
+
+/*
+// gets the rows of pixels to send. The tiles are sent from the band
+// they were rendered to
+*/
+static void ili9341_get_row(uint16_t x_pos, uint16_t y_pos, uint16_t width, LG_RGB* pixels)
+{
+	if (tiles_pending)
+		memcpy(pixels, &tile_band[y_pos - tile_band_y][x_pos - tile_band_x], width * sizeof(LG_RGB));
+	else
+		ILI9341_GET_SPAN(x_pos, y_pos, width, pixels);
+}
+
+#else
+
+/*
+// gets the rows of pixels to send
+*/
+#define ili9341_get_row(x_pos, y_pos, width, pixels)		ILI9341_GET_SPAN(x_pos, y_pos, width, pixels)
+
+#endif
+
+/*
+// defines the area of the screen that is scrolled. The area always
+// covers the whole height of the screen, a width of 0 disables 
+// scrolling
+*/
+void ili9341_set_scroll_area(uint16_t x_pos, uint16_t width)
+{
+	uint16_t old_x = scroll_next_x;
+	uint16_t old_width = scroll_next_width;
+	uint16_t old_offset = scroll_next_offset;
+	
+	scroll_next_x = x_pos;
+	scroll_next_width = width;
+	scroll_next_offset = 0;
+	scroll_pending = 1;
+	/*
+	// if the old area was scrolled it's contents move back 
+	// so we need to repaint it
+	*/
+	if (old_offset)
+		ili9341_paint_partial(old_x, 0, old_width, LCD_SCREEN_HEIGHT);
+}
+
+/*
+// scrolls a region of the screen. The panel only scrolls along the
+// screen x axis so only regions that cover the whole height of the
+// screen can be scrolled and only one at a time. Returns 0 if the 
+// region cannot be scrolled
+*/
+char ili9341_scroll(uint16_t x_pos, uint16_t y_pos, uint16_t width, uint16_t height, int16_t dx, int16_t dy)
+{
+	int16_t offset;
+	
+	if (dy || y_pos != 0 || height != LCD_SCREEN_HEIGHT || !width)
+		return 0;
+	/*
+	// the rest of a region that is being painted goes to the columns
+	// it was mapped to when it started, if the area moved under it
+	// those rows would show up on the wrong columns. Queued regions
+	// are mapped after the scroll is applied
+	*/
+	if (painting && x_start < x_pos + width && x_end > x_pos)
+		return 0;
+	if (split_width && split_x < x_pos + width && split_x + split_width > x_pos)
+		return 0;
+	#if defined(ILI9341_TILE_HASHING)
+		/*
+		// the band of tiles was rendered before the scroll
+		*/
+		if (tiles_pending && tile_band_x < x_pos + width && tile_band_x + tile_band_width > x_pos)
+			return 0;
+	#endif
+	/*
+	// if a different area is defined we can only take
+	// it over if it's not scrolled
+	*/
+	if (x_pos != scroll_next_x || width != scroll_next_width)
+	{
+		if (scroll_next_offset)
+			return 0;
+		scroll_next_x = x_pos;
+		scroll_next_width = width;
+	}
+	offset = ((int16_t) scroll_next_offset - dx) % (int16_t) width;
+	if (offset < 0)
+		offset += width;
+	scroll_next_offset = offset;
+	scroll_pending = 1;
+	return 1;
+}
+
+/*
+// request a full screen paint
+*/
+void ili9341_paint()
+{
+	#if defined(ILI9341_ENQUEUE_PAINT_REQUESTS)
+		ili9341_paint_partial(0, 0, LCD_SCREEN_WIDTH, LCD_SCREEN_HEIGHT);
+	#else
+		if (!painting)
+			ili9341_start_paint(0, 0, LCD_SCREEN_WIDTH, LCD_SCREEN_HEIGHT);
+	#endif
+}
+
+/*
+// request a partial paint. When requests are queued they are only
+// added to the queue, ili9341_do_processing starts painting them
+*/
+void ili9341_paint_partial(int16_t x_pos, int16_t y_pos, int16_t width, int16_t height)
+{
+	#if defined(ILI9341_ENQUEUE_PAINT_REQUESTS)
+		unsigned int head;
+		unsigned int next;
+		uint16_t disi;
+	#endif
+	
+	/*
+	// clip the region to the screen, the rows are rendered
+	// into buffers that are one screen row wide
+	*/
+	if (x_pos < 0)
+	{
+		width += x_pos;
+		x_pos = 0;
+	}
+	if (y_pos < 0)
+	{
+		height += y_pos;
+		y_pos = 0;
+	}
+	if (width <= 0 || height <= 0 || x_pos >= LCD_SCREEN_WIDTH || y_pos >= LCD_SCREEN_HEIGHT)
+		return;
+	if (width > LCD_SCREEN_WIDTH - x_pos)
+		width = LCD_SCREEN_WIDTH - x_pos;
+	if (height > LCD_SCREEN_HEIGHT - y_pos)
+		height = LCD_SCREEN_HEIGHT - y_pos;
+	
+	#if defined(ILI9341_ENQUEUE_PAINT_REQUESTS)
+		ILI9341_ENTER_PRODUCER(disi);
+		head = partial_paint_head;
+		next = (head + 1) & (ILI9341_PARTIAL_PAINT_LIMIT - 1);
+	
+		if (next == partial_paint_tail)
+		{
+			partial_paint_overflow = 1;
+			ILI9341_LEAVE_PRODUCER(disi);
+			return;
+		}
+		partial_paint[head].x = x_pos;
+		partial_paint[head].y = y_pos;
+		partial_paint[head].width = width;
+		partial_paint[head].height = height;
+		/*
+		// the entry must be written before it's published
+		*/
+		ILI9341_MEMORY_BARRIER();
+		partial_paint_head = next;
+		ILI9341_LEAVE_PRODUCER(disi);
+	#else
+		if (painting)
+		{
+			if ((x_pos < x_start || x_pos + width > x_end) ||
+				(y_pos < y_start || y_pos + height > y_end))			
+			{
+				ili9341_start_paint(MIN(x_start, x_pos), MIN(y_start, y_pos),
+					MAX(x_end, x_pos + width) - MIN(x_start, x_pos), 
+					MAX(y_end, y_pos + height) - MIN(y_start, y_pos));
+			}
+		}
+		else
+		{
+			ili9341_start_paint(x_pos, y_pos, width, height);
+		}
+	#endif
+}
+
+/*
+// turn display off. The command is sent by ili9341_do_processing
+// once the current paint is done
+*/
+void ili9341_display_off(void)
+{
+	ili9341_start_sequence(display_off_sequence);
+}
+
+/*
+// turn display on. The command is sent by ili9341_do_processing
+// once the current paint is done
+*/
+void ili9341_display_on(void)
+{
+	ili9341_start_sequence(display_on_sequence);
+}
+
+/*
+// put lcd driver in sleep mode. The commands are sent by
+// ili9341_do_processing once the current paint is done
+*/
+void ili9341_sleep(void)
+{
+	ili9341_start_sequence(sleep_sequence);
+}
+
+/*
+// wake up from sleep. The commands are sent by
+// ili9341_do_processing once the current paint is done
+*/
+void ili9341_wake(void)
+{
+	ili9341_start_sequence(wake_sequence);
+}
+
+/*
+// checks if the driver is painting or has paint requests queued
+*/
+char ili9341_is_painting()
+{
+	#if defined(ILI9341_ENQUEUE_PAINT_REQUESTS)
+		#if defined(ILI9341_TILE_HASHING)
+			if (tiles_pending)
+				return 1;
+		#endif
+		return painting || split_width || seq || partial_paint_head != partial_paint_tail || partial_paint_overflow;
+	#else
+		return painting || seq;
+	#endif
+}
+
+#if defined(ILI9341_USE_SPI_INTERRUPT)
+
+/*
+// sends the next byte of the row that is being sent
+*/
+static void ili9341_send_next(void)
+{
+	SPI2BUF = ((unsigned char*) isr_span)[2 - isr_byte] & 0x7E;
+	if (++isr_byte == 3)
+	{
+		isr_byte = 0;
+		isr_span++;
+		isr_pixels--;
+	}
+}
+
+/*
+// spi interrupt handler. Sends one byte each time the previous one
+// is done and disables itself when the row is done
+*/
+void ILI9341_ISR_ATTRIBUTES _SPI2Interrupt(void)
+{
+	unsigned char dummy;
+	
+	ILI9341_SPI_INTERRUPT_CLEAR();
+	dummy = SPI2BUF;
+	if (isr_pixels)
+	{
+		ili9341_send_next();
+	}
+	else
+	{
+		ILI9341_SPI_INTERRUPT_DISABLE();
+		isr_active = 0;
+	}
+	(void) dummy;
+}
+
+/*
+// renders the next row of the region being painted and hands
+// it to the interrupt handler when it's done with the previous
+// one. Returns the number of pixels handed over, 0 if a row was
+// rendered or -1 if there's nothing to do
+*/
+static int16_t ili9341_pump_rows(void)
+{
+	uint16_t width = x_end - x_start;
+	
+	if (!row_ready && y < y_end)
+	{
+		ili9341_get_row(x_start, y, width, row_buffer);
+		y++;
+		row_ready = 1;
+		return 0;
+	}
+	if (isr_active)
+		return -1;
+	
+	if (!row_ready)
+	{
+		painting = 0;
+		return 0;
+	}
+	/*
+	// send the first byte, the rest is sent by the
+	// interrupt handler
+	*/
+	isr_span = row_buffer;
+	isr_pixels = width;
+	isr_byte = 0;
+	isr_active = 1;
+	row_buffer = (row_buffer == span) ? span_back : span;
+	row_ready = 0;
+	
+	ILI9341_ASSERT_DATA();
+	ILI9341_SPI_INTERRUPT_CLEAR();
+	ili9341_send_next();
+	ILI9341_SPI_INTERRUPT_ENABLE();
+	#if defined(ILI9341_TRACE)
+		ili9341_trace_add_pixels(width);
+	#endif
+	return width;
+}
+
+#endif
+
+#if defined(ILI9341_ENQUEUE_PAINT_REQUESTS)
+
+/*
+// moves the queued request that shares the most of the address window
+// with the last one to the front of the queue so the column or page
+// address doesn't have to be sent again. The requests between the tail
+// and the head belong to the consumer so they can be swapped
+*/
+static void ili9341_reorder_requests(unsigned int tail, unsigned int head)
+{
+	unsigned int i;
+	unsigned int best = tail;
+	unsigned char score;
+	unsigned char best_score = 0;
+	ILI9341_PARTIAL_PAINT tmp;
+	
+	for (i = tail; i != head; i = (i + 1) & (ILI9341_PARTIAL_PAINT_LIMIT - 1))
+	{
+		score = 0;
+		if (partial_paint[i].x == last_request.x && partial_paint[i].width == last_request.width)
+			score++;
+		if (partial_paint[i].y == last_request.y && partial_paint[i].height == last_request.height)
+			score++;
+		if (score > best_score)
+		{
+			best = i;
+			best_score = score;
+			if (score == 2)
+				break;
+		}
+	}
+	if (best != tail)
+	{
+		tmp = partial_paint[tail];
+		partial_paint[tail] = partial_paint[best];
+		partial_paint[best] = tmp;
+	}
+}
+
+#endif
+
+/*
+// does the next step of the painting. Returns the number of pixels
+// completed (0 or 1) or -1 if nothing could be done because the spi
+// is busy or there's nothing to paint
+*/
+static int16_t ili9341_step(void)
+{
+	#if !defined(ILI9341_USE_SPI_INTERRUPT)
+		static char pixel_fetched = 0;
+		static uint32_t pixel_color;
+	#endif
+	
+	if (painting)
+	{
+		#if defined(ILI9341_USE_SPI_INTERRUPT)
+			return ili9341_pump_rows();
+		#else
+		/*
+		// get pixel from graphics library
+		*/
+		if (!pixel_fetched)
+		{
+			/*
+			// render the whole row at once when we start
+			// a new one
+			*/
+			if (x == x_start)
+			{
+				ili9341_get_row(x_start, y, x_end - x_start, span);
+			}
+			pixel_color = span[x - x_start];
+			pixel_color &= 0x7e7e7e;
+			pixel_fetched = 1;
+		}
+		/*
+		// if the spi is busy return
+		*/
+		if (!spi_ready(SPI_GET_MODULE(2)))
+			return -1;
+		/*
+		// send pixel to LCD driver
+		*/
+		switch (current_byte)
+		{
+			case 0:
+				LCD_WRITE_DATA_ASYNC(((unsigned char*) &pixel_color)[2]);
+				current_byte = 1;
+				return 0;
+			case 1:			
+				LCD_WRITE_DATA_ASYNC(((unsigned char*) &pixel_color)[1]);
+				current_byte = 2;
+				return 0;
+			case 2:
+				LCD_WRITE_DATA_ASYNC(((unsigned char*) &pixel_color)[0]);
+				current_byte = 0;
+				pixel_fetched = 0;
+				#if defined(ILI9341_TRACE)
+					ili9341_trace_add_pixels(1);
+				#endif
+				
+				x++;
+				if (x >= x_end) 
+				{
+					x = x_start;
+					y++;
+					if (y >= y_end)
+					{
+						while (!SPI2STATbits.SPIRBF);
+						painting = SPI2BUF;
+						painting = 0;
+					}
+				}
+				break;
+		}
+		return 1;
+		#endif
+	}
+	else if (split_width)
+	{
+		/*
+		// paint the rest of a region that was split
+		*/
+		ili9341_start_paint(split_x, split_y, split_width, split_height);
+		return 0;
+	}
+	#if defined(ILI9341_TILE_HASHING)
+	else if (tiles_pending)
+	{
+		return ili9341_tile_step();
+	}
+	#endif
+	else if (seq)
+	{
+		return ili9341_sequence_step();
+	}
+	else
+	{
+		if (scroll_pending)
+			ili9341_apply_scroll();
+		
+		#if defined(ILI9341_ENQUEUE_PAINT_REQUESTS)
+		if (partial_paint_overflow)
+		{
+			/*
+			// requests were lost so we drop the rest and
+			// paint the whole screen
+			*/
+			partial_paint_overflow = 0;
+			partial_paint_tail = partial_paint_head;
+			#if defined(ILI9341_TILE_HASHING)
+				ili9341_start_tiles(0, 0, LCD_SCREEN_WIDTH, LCD_SCREEN_HEIGHT);
+			#else
+				ili9341_start_paint(0, 0, LCD_SCREEN_WIDTH, LCD_SCREEN_HEIGHT);
+			#endif
+			return 0;
+		}
+		if (partial_paint_tail != partial_paint_head)
+		{
+			ILI9341_PARTIAL_PAINT request;
+			unsigned int tail = partial_paint_tail;
+			/*
+			// the entry must be read before it's released
+			*/
+			ILI9341_MEMORY_BARRIER();
+			ili9341_reorder_requests(tail, partial_paint_head);
+			request = partial_paint[tail];
+			ILI9341_MEMORY_BARRIER();
+			partial_paint_tail = (tail + 1) & (ILI9341_PARTIAL_PAINT_LIMIT - 1);
+			last_request = request;
+			#if defined(ILI9341_TILE_HASHING)
+				ili9341_start_tiles(request.x, request.y, request.width, request.height);
+			#else
+				ili9341_start_paint(request.x, request.y, request.width, request.height);
+			#endif
+			return 0;
+		}
+		#endif	
+	}
+	#if defined(ILI9341_TRACE)
+		/*
+		// everything requested has been painted, that's the
+		// end of a frame
+		*/
+		if (trace_busy)
+		{
+			ili9341_trace_flush();
+			ili9341_trace_record(ILI9341_TRACE_IDLE, 1, 0);
+			trace_busy = 0;
+		}
+	#endif
+	return -1;
+}
+
+/*
+// performs the painting in the "background"
+// must be called from application loop
+*/
+void ili9341_do_processing()
+{
+	ili9341_step();
+}
+
+/*
+// gets the number of pixels that remain to be painted including
+// the rest of the current region and all queued regions
+*/
+uint32_t ili9341_get_pending_pixels(void)
+{
+	uint32_t pixels = 0;
+	#if defined(ILI9341_ENQUEUE_PAINT_REQUESTS)
+		unsigned int i;
+	#endif
+	#if defined(ILI9341_TILE_HASHING)
+		uint16_t band_y;
+		uint16_t band_end;
+		uint16_t band_x;
+	#endif
+	
+	if (painting)
+	{
+		#if defined(ILI9341_USE_SPI_INTERRUPT)
+			pixels = (uint32_t) (y_end - y + row_ready) * (x_end - x_start) + isr_pixels;
+		#else
+			pixels = (uint32_t) (y_end - y) * (x_end - x_start) - (x - x_start);
+		#endif
+		pixels += (uint32_t) split_width * split_height;
+	}
+	#if defined(ILI9341_ENQUEUE_PAINT_REQUESTS)
+		if (partial_paint_overflow)
+			pixels += (uint32_t) LCD_SCREEN_WIDTH * LCD_SCREEN_HEIGHT;
+		for (i = partial_paint_tail; i != partial_paint_head; i = (i + 1) & (ILI9341_PARTIAL_PAINT_LIMIT - 1))
+			pixels += (uint32_t) partial_paint[i].width * partial_paint[i].height;
+	#endif
+	#if defined(ILI9341_TILE_HASHING)
+		if (tiles_pending)
+		{
+			/*
+			// the tiles of the band that are not sent yet and
+			// the rest of the region below the band
+			*/
+			band_y = MAX(tile_band_y, tile_request.y);
+			band_end = MIN(tile_band_y + tile_band_height, tile_request.y + tile_request.height);
+			band_x = MIN(MAX((uint16_t) tile_column * ILI9341_TILE_SIZE, tile_request.x), 
+				tile_request.x + tile_request.width);
+			pixels += (uint32_t) (band_end - band_y) * (tile_request.x + tile_request.width - band_x);
+			pixels += (uint32_t) (tile_request.y + tile_request.height - band_end) * tile_request.width;
+		}
+	#endif
+	return pixels;
+}
+
+/*
+// performs the painting in the "background" until the given number
+// of pixels are painted, the given number of microseconds elapse or
+// the spi is busy, whichever happens first. A budget of 0 is unlimited.
+// The time budget is as fine as ILI9341_GET_MICROSECONDS. Returns the
+// number of pixels that remain to be painted
+*/
+uint32_t ili9341_do_processing_budget(uint16_t pixels, uint16_t microseconds)
+{
+	int16_t done;
+	uint16_t count = 0;
+	uint32_t start = ILI9341_GET_MICROSECONDS();
+	
+	while ((done = ili9341_step()) >= 0)
+	{
+		count += done;
+		if (pixels && count >= pixels)
+			break;
+		if (microseconds && (uint32_t) (ILI9341_GET_MICROSECONDS() - start) >= microseconds)
+			break;
+	}
+	return ili9341_get_pending_pixels();
+}
+
+/*
+// initializes the driver. The display is reset and the power on
+// sequence is sent by ili9341_do_processing, paint requests made
+// in the meantime are painted when it's done
+*/
+void ili9341_init()
+{
+	/*
+	// initialize IO pins
+	*/
+	ILI9341_IO_INIT();
+	/*
+	// initialize spi module
+	*/
+	spi_init(SPI_GET_MODULE(2));
+	spi_set_clock(SPI_GET_MODULE(2), 9000000L);
+	/*
+	// assert chip-select line and reset, the reset is released
+	// by the power on sequence
+	*/
+	ILI9341_ASSERT_CS();
+	ILI9341_ASSERT_RESET();
+	seq = init_sequence;
+	seq_next = NULL;
+	seq_delay = 0;
+	spi_busy = 0;
+	window_valid = 0;
+	bytes_saved = 0;
 	/*
 	// initialize variables to known values
 	*/	
@@ -616,5 +1858,25 @@ void ili9341_init()
 	y = 0;
 	x_end = LCD_SCREEN_WIDTH;
 	y_end = LCD_SCREEN_HEIGHT;
+	split_width = 0;
+	scroll_x = scroll_next_x = 0;
+	scroll_width = scroll_next_width = 0;
+	scroll_offset = scroll_next_offset = 0;
+	scroll_pending = 0;
 	painting = 0;
+	#if defined(ILI9341_ENQUEUE_PAINT_REQUESTS)
+		partial_paint_head = 0;
+		partial_paint_tail = 0;
+		partial_paint_overflow = 0;
+	#endif
+	#if defined(ILI9341_USE_SPI_INTERRUPT)
+		row_ready = 0;
+		isr_pixels = 0;
+		isr_active = 0;
+	#endif
+	#if defined(ILI9341_TILE_HASHING)
+		memset(tile_hash, 0, sizeof(tile_hash));
+		tiles_pending = 0;
+		tiles_skipped = 0;
+	#endif
 }
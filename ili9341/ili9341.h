@@ -23,15 +23,96 @@
 #ifndef ILI9341
 #define ILI9341
 
+#if defined(ILI9341_TRACE)
+
+/*
+// trace record types. Each record starts with the type followed by:
+//
+// ILI9341_TRACE_COMMAND: the command
+// ILI9341_TRACE_DATA: a parameter byte
+// ILI9341_TRACE_PIXELS: the number of pixels sent (16 bits, little endian)
+// ILI9341_TRACE_IDLE: nothing, the driver finished painting everything
+//   requested (the end of a frame)
+//
+// records are not timestamped. A byte takes about a microsecond on the
+// bus and the only timer the driver has counts milliseconds, so timing
+// is left to ili9341_trace_estimate
+*/
+#define ILI9341_TRACE_COMMAND	(0x01)
+#define ILI9341_TRACE_DATA		(0x02)
+#define ILI9341_TRACE_PIXELS	(0x03)
+#define ILI9341_TRACE_IDLE		(0x04)
+
+/*
+// results of ili9341_trace_analyze
+*/
+typedef struct ILI9341_TRACE_STATS
+{
+	uint32_t window_bytes;		/* column, page and memory write commands and parameters */
+	uint32_t scroll_bytes;		/* scroll commands and parameters */
+	uint32_t other_bytes;		/* all other commands and parameters */
+	uint32_t pixel_bytes;
+	uint32_t pixels;
+	uint32_t overdraw;			/* pixels painted more than once on the same frame */
+	uint32_t bus_time;			/* microseconds */
+	uint16_t windows;
+	uint16_t redundant_windows;	/* column or page addresses that didn't change */
+	uint16_t frames;
+}
+ILI9341_TRACE_STATS;
+
+/*
+// parameters used by ili9341_trace_estimate to predict how long a
+// trace takes on the target
+*/
+typedef struct ILI9341_COST_MODEL
+{
+	uint32_t clock;				/* spi clock in Hz */
+	uint16_t byte_overhead;		/* ns the cpu spends on each byte besides shifting it out */
+	uint16_t dc_toggle;			/* ns to switch between commands and data */
+	uint16_t pixel_render;		/* ns to render a pixel */
+	char overlapped;			/* non-zero if rendering overlaps the transfers */
+}
+ILI9341_COST_MODEL;
+
+/*
+// results of ili9341_trace_estimate
+*/
+typedef struct ILI9341_TRACE_ESTIMATE
+{
+	uint32_t total_time;		/* microseconds */
+	uint32_t average_frame_time;	/* microseconds */
+	uint32_t worst_frame_time;	/* microseconds */
+	uint16_t fps;
+	uint16_t frames;
+}
+ILI9341_TRACE_ESTIMATE;
+
+#endif
+
 void ili9341_init();
 void ili9341_paint();
 void ili9341_paint_partial(int16_t x, int16_t y, int16_t width, int16_t height);
 char ili9341_is_painting();
 void ili9341_do_processing();
+uint32_t ili9341_do_processing_budget(uint16_t pixels, uint16_t microseconds);
+uint32_t ili9341_get_pending_pixels(void);
+uint32_t ili9341_get_bytes_saved(void);
+#if defined(ILI9341_TILE_HASHING)
+uint32_t ili9341_get_tiles_skipped(void);
+#endif
+#if defined(ILI9341_TRACE)
+void ili9341_trace_start(unsigned char* buffer, uint16_t size);
+uint16_t ili9341_trace_stop(void);
+char ili9341_trace_analyze(const unsigned char* trace, uint16_t length, uint32_t clock, ILI9341_TRACE_STATS* stats);
+char ili9341_trace_estimate(const unsigned char* trace, uint16_t length, const ILI9341_COST_MODEL* model, ILI9341_TRACE_ESTIMATE* estimate);
+#endif
 void ili9341_sleep(void);
 void ili9341_wake(void);
 void ili9341_display_on(void);
 void ili9341_display_off(void);
+void ili9341_set_scroll_area(uint16_t x, uint16_t width);
+char ili9341_scroll(uint16_t x, uint16_t y, uint16_t width, uint16_t height, int16_t dx, int16_t dy);
 
 
 #endif
@@ -0,0 +1,523 @@
+/*
+ * lglib - Lightweight Graphics Library for Embedded Systems
+ * Copyright (C) 2013 Fernando Rodriguez (support@fernansoft.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "lg.h"
+#include "element.h"
+
+#define LG_MAX_AA_SHAPES		8
+
+#define LG_AA_LINE				0
+#define LG_AA_CIRCLE			1
+#define LG_AA_ARC				2
+
+/*
+// line coordinates are stored with 4 fractional bits
+// so needles can rotate smoothly
+*/
+#define LG_AA_SUBPIXEL_BITS		4
+
+typedef struct LG_AA_SHAPE
+{
+	char in_use;
+	unsigned char type;
+	char wide_arc;
+	int16_t index;
+	int16_t x1;
+	int16_t y1;
+	int16_t x2;
+	int16_t y2;
+	int16_t radius;
+	int16_t inner_radius;
+	int16_t start_x;
+	int16_t start_y;
+	int16_t end_x;
+	int16_t end_y;
+	int16_t length;
+	LG_RGB color;
+}
+LG_AA_SHAPE;
+
+static LG_AA_SHAPE aa_shapes[LG_MAX_AA_SHAPES];
+
+/*
+// sine table for 0 - 90 degrees (1.0 = 16384)
+*/
+static const int16_t sin_table[91] = 
+{
+	0, 286, 572, 857, 1143, 1428, 1713, 1997, 2280, 2563,
+	2845, 3126, 3406, 3686, 3964, 4240, 4516, 4790, 5063, 5334,
+	5604, 5872, 6138, 6402, 6664, 6924, 7182, 7438, 7692, 7943,
+	8192, 8438, 8682, 8923, 9162, 9397, 9630, 9860, 10087, 10311,
+	10531, 10749, 10963, 11174, 11381, 11585, 11786, 11982, 12176, 12365,
+	12551, 12733, 12911, 13085, 13255, 13421, 13583, 13741, 13894, 14044,
+	14189, 14330, 14466, 14598, 14726, 14849, 14968, 15082, 15191, 15296,
+	15396, 15491, 15582, 15668, 15749, 15826, 15897, 15964, 16026, 16083,
+	16135, 16182, 16225, 16262, 16294, 16322, 16344, 16362, 16374, 16382,
+	16384
+};
+
+/*
+// prototypes
+*/
+static void lg_aa_line_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span);
+static void lg_aa_circle_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span);
+static void lg_aa_release(void* data);
+
+static const LG_ELEMENT_OPS aa_line_ops = { lg_aa_line_render, lg_aa_release };
+static const LG_ELEMENT_OPS aa_circle_ops = { lg_aa_circle_render, lg_aa_release };
+
+/*
+// gets the sine of an angle in degrees (1.0 = 16384)
+*/
+int16_t lg_sin(int16_t angle)
+{
+	angle %= 360;
+	if (angle < 0)
+		angle += 360;
+	
+	if (angle <= 90)
+		return sin_table[angle];
+	else if (angle <= 180)
+		return sin_table[180 - angle];
+	else if (angle <= 270)
+		return -sin_table[angle - 180];
+	else
+		return -sin_table[360 - angle];
+}
+
+/*
+// gets the cosine of an angle in degrees (1.0 = 16384)
+*/
+int16_t lg_cos(int16_t angle)
+{
+	return lg_sin(angle + 90);
+}
+
+/*
+// integer square root
+*/
+uint16_t lg_isqrt(uint32_t value)
+{
+	uint32_t root = 0;
+	uint32_t bit = 1UL << 30;
+	
+	while (bit > value)
+		bit >>= 2;
+	
+	while (bit)
+	{
+		if (value >= root + bit)
+		{
+			value -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else
+		{
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint16_t) root;
+}
+
+/*
+// allocates an anti-aliased shape
+*/
+static LG_AA_SHAPE* lg_aa_alloc(unsigned char type, LG_RGB color)
+{
+	int16_t i;
+	for (i = 0; i < LG_MAX_AA_SHAPES; i++)
+	{
+		if (!aa_shapes[i].in_use)
+		{
+			aa_shapes[i].type = type;
+			aa_shapes[i].color = color;
+			aa_shapes[i].wide_arc = 0;
+			return &aa_shapes[i];
+		}
+	}
+	return NULL;
+}
+
+/*
+// releases an anti-aliased shape
+*/
+static void lg_aa_release(void* data)
+{
+	((LG_AA_SHAPE*) data)->in_use = 0;
+}
+
+/*
+// calculates the bounds of a line. Each column of a line touches
+// two rows so we include the row bellow the last one
+*/
+static void lg_aa_line_bounds(LG_AA_SHAPE* shape, uint16_t* x, uint16_t* y, uint16_t* width, uint16_t* height)
+{
+	int16_t x_min = MIN(shape->x1, shape->x2) >> LG_AA_SUBPIXEL_BITS;
+	int16_t y_min = MIN(shape->y1, shape->y2) >> LG_AA_SUBPIXEL_BITS;
+	int16_t x_max = (MAX(shape->x1, shape->x2) >> LG_AA_SUBPIXEL_BITS) + 2;
+	int16_t y_max = (MAX(shape->y1, shape->y2) >> LG_AA_SUBPIXEL_BITS) + 2;
+	
+	*x = (uint16_t) MAX(x_min, 0);
+	*y = (uint16_t) MAX(y_min, 0);
+	*width = x_max - *x;
+	*height = y_max - *y;
+}
+
+/*
+// adds a line in sub-pixel coordinates
+*/
+static int16_t lg_aa_line_add(int16_t x1, int16_t y1, int16_t x2, int16_t y2, LG_RGB color)
+{
+	uint16_t x;
+	uint16_t y;
+	uint16_t width;
+	uint16_t height;
+	LG_AA_SHAPE* shape = lg_aa_alloc(LG_AA_LINE, color);
+	
+	if (shape == NULL)
+		return -1;
+	
+	shape->x1 = x1;
+	shape->y1 = y1;
+	shape->x2 = x2;
+	shape->y2 = y2;
+	lg_aa_line_bounds(shape, &x, &y, &width, &height);
+	
+	shape->index = lg_element_add(&aa_line_ops, shape, LG_LAYER_CONTENT, x, y, width, height);
+	if (shape->index >= 0)
+		shape->in_use = 1;
+	return shape->index;
+}
+
+/*
+// adds an anti-aliased line to the display
+*/
+int16_t lg_aaline_add(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, LG_RGB color)
+{
+	return lg_aa_line_add(x1 << LG_AA_SUBPIXEL_BITS, y1 << LG_AA_SUBPIXEL_BITS, 
+		x2 << LG_AA_SUBPIXEL_BITS, y2 << LG_AA_SUBPIXEL_BITS, color);
+}
+
+/*
+// adds a gauge needle to the display
+*/
+int16_t lg_needle_add(uint16_t cx, uint16_t cy, uint16_t length, int16_t angle, LG_RGB color)
+{
+	int16_t index;
+	
+	index = lg_aa_line_add(cx << LG_AA_SUBPIXEL_BITS, cy << LG_AA_SUBPIXEL_BITS, 
+		cx << LG_AA_SUBPIXEL_BITS, cy << LG_AA_SUBPIXEL_BITS, color);
+	if (index >= 0)
+	{
+		((LG_AA_SHAPE*) lg_element_get_data(index))->length = length;
+		lg_needle_set_angle(index, angle);
+	}
+	return index;
+}
+
+/*
+// sets the angle of a gauge needle. Only the bounds of the
+// old and new needle are repainted
+*/
+void lg_needle_set_angle(uint16_t index, int16_t angle)
+{
+	uint16_t x;
+	uint16_t y;
+	uint16_t width;
+	uint16_t height;
+	LG_AA_SHAPE* shape = (LG_AA_SHAPE*) lg_element_get_data(index);
+	
+	shape->x2 = shape->x1 + (int16_t) (((int32_t) shape->length * lg_cos(angle)) >> (14 - LG_AA_SUBPIXEL_BITS));
+	shape->y2 = shape->y1 + (int16_t) (((int32_t) shape->length * lg_sin(angle)) >> (14 - LG_AA_SUBPIXEL_BITS));
+	lg_aa_line_bounds(shape, &x, &y, &width, &height);
+	lg_element_set_bounds(index, x, y, width, height);
+}
+
+/*
+// adds a circle or arc
+*/
+static int16_t lg_aa_circle_add(unsigned char type, uint16_t cx, uint16_t cy, uint16_t radius, 
+	unsigned char thickness, LG_RGB color)
+{
+	LG_AA_SHAPE* shape = lg_aa_alloc(type, color);
+	
+	if (shape == NULL)
+		return -1;
+	
+	shape->x1 = cx;
+	shape->y1 = cy;
+	shape->radius = radius;
+	shape->inner_radius = (thickness && thickness < radius) ? radius - thickness : 0;
+	shape->start_x = lg_cos(0);
+	shape->start_y = lg_sin(0);
+	shape->end_x = shape->start_x;
+	shape->end_y = shape->start_y;
+	shape->index = lg_element_add(&aa_circle_ops, shape, LG_LAYER_CONTENT, 
+		(cx > radius) ? cx - radius : 0, (cy > radius) ? cy - radius : 0, 
+		radius * 2 + 1, radius * 2 + 1);
+	if (shape->index >= 0)
+		shape->in_use = 1;
+	return shape->index;
+}
+
+/*
+// adds an anti-aliased circle to the display
+*/
+int16_t lg_circle_add(uint16_t cx, uint16_t cy, uint16_t radius, unsigned char thickness, LG_RGB color)
+{
+	return lg_aa_circle_add(LG_AA_CIRCLE, cx, cy, radius, thickness, color);
+}
+
+/*
+// adds an anti-aliased arc to the display
+*/
+int16_t lg_arc_add(uint16_t cx, uint16_t cy, uint16_t radius, unsigned char thickness, 
+	int16_t start_angle, int16_t end_angle, LG_RGB color)
+{
+	int16_t index;
+	int16_t sweep;
+	LG_AA_SHAPE* shape;
+	
+	index = lg_aa_circle_add(LG_AA_ARC, cx, cy, radius, thickness, color);
+	if (index >= 0)
+	{
+		shape = (LG_AA_SHAPE*) lg_element_get_data(index);
+		sweep = (end_angle - start_angle) % 360;
+		if (sweep < 0)
+			sweep += 360;
+		shape->wide_arc = (sweep > 180);
+		shape->start_x = lg_cos(start_angle);
+		shape->start_y = lg_sin(start_angle);
+		shape->end_x = lg_cos(end_angle);
+		shape->end_y = lg_sin(end_angle);
+	}
+	return index;
+}
+
+/*
+// sets the color of an anti-aliased shape
+*/
+void lg_aa_set_color(uint16_t index, LG_RGB color)
+{
+	LG_AA_SHAPE* shape = (LG_AA_SHAPE*) lg_element_get_data(index);
+	if (shape->color != color)
+	{
+		shape->color = color;
+		lg_element_invalidate(index);
+	}
+}
+
+/*
+// renders a span of an anti-aliased line using Wu's algorithm. Each
+// column (or row for y-major lines) of the line is split between the two
+// pixels closest to the line based on the fractional part of the distance
+*/
+static void lg_aa_line_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span)
+{
+	int16_t dx;
+	int16_t dy;
+	int16_t px;
+	int16_t px_end;
+	int16_t x1;
+	int16_t y1;
+	int16_t x2;
+	int16_t y2;
+	int32_t pos;
+	unsigned char frac;
+	LG_AA_SHAPE* shape = (LG_AA_SHAPE*) data;
+	/*
+	// order the end points left to right for x-major lines
+	// and top to bottom for y-major lines
+	*/
+	dx = shape->x2 - shape->x1;
+	dy = shape->y2 - shape->y1;
+	if ((dx < 0 ? -dx : dx) >= (dy < 0 ? -dy : dy) ? (dx < 0) : (dy < 0))
+	{
+		x1 = shape->x2;
+		y1 = shape->y2;
+		x2 = shape->x1;
+		y2 = shape->y1;
+		dx = -dx;
+		dy = -dy;
+	}
+	else
+	{
+		x1 = shape->x1;
+		y1 = shape->y1;
+		x2 = shape->x2;
+		y2 = shape->y2;
+	}
+	
+	if (dx == 0 && dy == 0)
+		return;
+	
+	if (dx >= (dy < 0 ? -dy : dy))
+	{
+		/*
+		// x-major line, only the columns where the line's center is 
+		// less than one pixel away from this row are touched
+		*/
+		if (dy == 0)
+		{
+			px = x1 >> LG_AA_SUBPIXEL_BITS;
+			px_end = (x2 >> LG_AA_SUBPIXEL_BITS) + 1;
+		}
+		else
+		{
+			px = (x1 + (int16_t) ((((int32_t) ((y - 1) << LG_AA_SUBPIXEL_BITS) - y1) * dx) / dy)) >> LG_AA_SUBPIXEL_BITS;
+			px_end = (x1 + (int16_t) ((((int32_t) ((y + 1) << LG_AA_SUBPIXEL_BITS) - y1) * dx) / dy)) >> LG_AA_SUBPIXEL_BITS;
+			if (px > px_end)
+			{
+				pos = px;
+				px = px_end;
+				px_end = (int16_t) pos;
+			}
+			px--;
+			px_end += 2;
+			px = MAX(px, x1 >> LG_AA_SUBPIXEL_BITS);
+			px_end = MIN(px_end, (x2 >> LG_AA_SUBPIXEL_BITS) + 1);
+		}
+		px = MAX(px, (int16_t) x);
+		px_end = MIN(px_end, (int16_t) (x + width));
+		
+		for (; px < px_end; px++)
+		{
+			/*
+			// center of the line at this column with 8 fractional bits
+			*/
+			pos = ((int32_t) y1 << (8 - LG_AA_SUBPIXEL_BITS)) + 
+				((((int32_t) (px << LG_AA_SUBPIXEL_BITS) - x1) * dy) << (8 - LG_AA_SUBPIXEL_BITS)) / dx;
+			frac = (unsigned char) (pos & 0xFF);
+			if ((pos >> 8) == y)
+			{
+				span[px - x] = lg_blend(span[px - x], shape->color, 0xFF - frac);
+			}
+			else if ((pos >> 8) + 1 == y)
+			{
+				span[px - x] = lg_blend(span[px - x], shape->color, frac);
+			}
+		}
+	}
+	else
+	{
+		/*
+		// y-major line, each row is covered by two pixels
+		*/
+		if ((int16_t) y < (y1 >> LG_AA_SUBPIXEL_BITS) || (int16_t) y > (y2 >> LG_AA_SUBPIXEL_BITS))
+			return;
+		
+		pos = ((int32_t) x1 << (8 - LG_AA_SUBPIXEL_BITS)) + 
+			((((int32_t) (y << LG_AA_SUBPIXEL_BITS) - y1) * dx) << (8 - LG_AA_SUBPIXEL_BITS)) / dy;
+		frac = (unsigned char) (pos & 0xFF);
+		px = (int16_t) (pos >> 8);
+		
+		if (px >= (int16_t) x && px < (int16_t) (x + width))
+			span[px - x] = lg_blend(span[px - x], shape->color, 0xFF - frac);
+		px++;
+		if (px >= (int16_t) x && px < (int16_t) (x + width))
+			span[px - x] = lg_blend(span[px - x], shape->color, frac);
+	}
+}
+
+/*
+// gets the coverage of a pixel on the edge of a circle from it's
+// squared distance to the center. The distance from the edge is
+// approximated as (d^2 - r^2) / 2r so we don't need a square root
+*/
+static int16_t lg_aa_edge_coverage(int32_t dist2, int16_t radius)
+{
+	int32_t edge;
+	
+	edge = (((int32_t) radius * radius - dist2) << 8) / (radius * 2) + 128;
+	if (edge <= 0)
+		return 0;
+	if (edge >= 255)
+		return 255;
+	return (int16_t) edge;
+}
+
+/*
+// checks if a point is within the sweep of an arc
+*/
+static char lg_aa_in_arc(LG_AA_SHAPE* shape, int16_t dx, int16_t dy)
+{
+	char after_start;
+	char before_end;
+	
+	after_start = ((int32_t) shape->start_x * dy - (int32_t) shape->start_y * dx) >= 0;
+	before_end = ((int32_t) dx * shape->end_y - (int32_t) dy * shape->end_x) >= 0;
+	
+	if (shape->wide_arc)
+		return after_start || before_end;
+	return after_start && before_end;
+}
+
+/*
+// renders a span of an anti-aliased circle or arc
+*/
+static void lg_aa_circle_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span)
+{
+	int16_t dx;
+	int16_t dy;
+	int16_t px;
+	int16_t px_end;
+	int16_t outer;
+	int16_t inner;
+	int16_t coverage;
+	int32_t dist2;
+	LG_AA_SHAPE* shape = (LG_AA_SHAPE*) data;
+	
+	dy = (int16_t) y - shape->y1;
+	dist2 = (int32_t) dy * dy;
+	/*
+	// find the horizontal extent of the circle and of it's hole
+	// on this row so we only test pixels near the edges
+	*/
+	if (dist2 > (int32_t) (shape->radius + 1) * (shape->radius + 1))
+		return;
+	outer = lg_isqrt((int32_t) (shape->radius + 1) * (shape->radius + 1) - dist2);
+	inner = 0;
+	if (shape->inner_radius > 1 && dist2 < (int32_t) (shape->inner_radius - 1) * (shape->inner_radius - 1))
+		inner = lg_isqrt((int32_t) (shape->inner_radius - 1) * (shape->inner_radius - 1) - dist2);
+	
+	px = MAX(shape->x1 - outer, (int16_t) x);
+	px_end = MIN(shape->x1 + outer + 1, (int16_t) (x + width));
+	
+	for (; px < px_end; px++)
+	{
+		dx = px - shape->x1;
+		if (inner && dx > -inner && dx < inner)
+		{
+			px = shape->x1 + inner - 1;
+			continue;
+		}
+		if (shape->type == LG_AA_ARC && !lg_aa_in_arc(shape, dx, dy))
+			continue;
+		
+		dist2 = (int32_t) dx * dx + (int32_t) dy * dy;
+		coverage = lg_aa_edge_coverage(dist2, shape->radius);
+		if (shape->inner_radius)
+			coverage = MIN(coverage, 255 - lg_aa_edge_coverage(dist2, shape->inner_radius));
+		
+		if (coverage > 0)
+			span[px - x] = lg_blend(span[px - x], shape->color, (unsigned char) coverage);
+	}
+}
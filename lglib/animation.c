@@ -0,0 +1,352 @@
+/*
+ * lglib - Lightweight Graphics Library for Embedded Systems
+ * Copyright (C) 2013 Fernando Rodriguez (support@fernansoft.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "lg.h"
+#include "element.h"
+
+#define LG_MAX_ANIMATIONS			2
+#define LG_ANIMATION_BUDGET			512		/* pixels decoded per call to lg_animation_process */
+#define LG_ANIMATION_HEADER_SIZE	12
+
+/*
+// decoder states
+*/
+#define LG_ANIMATION_IDLE			0
+#define LG_ANIMATION_RECT			1
+#define LG_ANIMATION_PIXELS			2
+
+typedef struct LG_ANIMATION
+{
+	char in_use;
+	char playing;
+	char loop;
+	char starting;
+	unsigned char state;
+	int16_t index;
+	uint16_t x;
+	uint16_t y;
+	uint16_t width;
+	uint16_t height;
+	uint16_t frame_count;
+	uint16_t frame;
+	uint16_t period;
+	uint32_t frame_time;
+	uint16_t* framebuffer;
+	/*
+	// current rectangle
+	*/
+	unsigned char rects_left;
+	uint16_t rect_x;
+	uint16_t rect_y;
+	uint16_t rect_width;
+	uint16_t rect_height;
+	uint16_t col;
+	uint16_t row;
+	/*
+	// RLE decoder
+	*/
+	unsigned char count;
+	char repeat;
+	uint16_t pixel;
+	LG_STREAM stream;
+}
+LG_ANIMATION;
+
+static LG_ANIMATION animations[LG_MAX_ANIMATIONS];
+
+/*
+// prototypes
+*/
+static void lg_animation_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span);
+static void lg_animation_release(void* data);
+
+static const LG_ELEMENT_OPS animation_ops = { lg_animation_render, lg_animation_release };
+
+/*
+// reads the animation header and adds it to the display
+*/
+static int16_t lg_animation_init(LG_ANIMATION* animation, uint16_t* framebuffer, uint16_t x, uint16_t y)
+{
+	LG_STREAM* stream = &animation->stream;
+	
+	if (lg_stream_byte(stream) != 'L' || lg_stream_byte(stream) != 'G' || 
+		lg_stream_byte(stream) != 'A' || lg_stream_byte(stream) != 1)
+	{
+		return -1;
+	}
+	animation->width = lg_stream_word(stream);
+	animation->height = lg_stream_word(stream);
+	animation->frame_count = lg_stream_word(stream);
+	animation->period = lg_stream_word(stream);
+	animation->framebuffer = framebuffer;
+	animation->x = x;
+	animation->y = y;
+	animation->playing = 0;
+	animation->state = LG_ANIMATION_IDLE;
+	/*
+	// the element is hidden until the first frame is decoded
+	*/
+	animation->index = lg_element_add(&animation_ops, animation, LG_LAYER_CONTENT, 
+		x, y, animation->width, animation->height);
+	if (animation->index >= 0)
+	{
+		lg_element_set_visibility(animation->index, 0);
+		animation->in_use = 1;
+	}
+	return animation->index;
+}
+
+/*
+// finds a free animation slot
+*/
+static LG_ANIMATION* lg_animation_alloc(void)
+{
+	int16_t i;
+	for (i = 0; i < LG_MAX_ANIMATIONS; i++)
+	{
+		if (!animations[i].in_use)
+			return &animations[i];
+	}
+	return NULL;
+}
+
+/*
+// adds an animation stored in memory to the display
+*/
+int16_t lg_animation_add_memory(const unsigned char* data, uint32_t size, 
+	uint16_t* framebuffer, uint16_t x, uint16_t y)
+{
+	LG_ANIMATION* animation = lg_animation_alloc();
+	if (animation == NULL)
+		return -1;
+	lg_stream_open_memory(&animation->stream, data, size);
+	return lg_animation_init(animation, framebuffer, x, y);
+}
+
+/*
+// adds an animation that is read through a callback to the display
+*/
+int16_t lg_animation_add(LG_STREAM_READ read, void* context, 
+	uint16_t* framebuffer, uint16_t x, uint16_t y)
+{
+	LG_ANIMATION* animation = lg_animation_alloc();
+	if (animation == NULL)
+		return -1;
+	lg_stream_open(&animation->stream, read, context);
+	return lg_animation_init(animation, framebuffer, x, y);
+}
+
+/*
+// releases an animation
+*/
+static void lg_animation_release(void* data)
+{
+	((LG_ANIMATION*) data)->in_use = 0;
+}
+
+/*
+// starts playing an animation from the first frame
+*/
+void lg_animation_play(uint16_t index, char loop)
+{
+	LG_ANIMATION* animation = (LG_ANIMATION*) lg_element_get_data(index);
+	lg_stream_seek(&animation->stream, LG_ANIMATION_HEADER_SIZE);
+	animation->frame = 0;
+	animation->loop = loop;
+	animation->state = LG_ANIMATION_IDLE;
+	animation->starting = 1;
+	animation->playing = 1;
+}
+
+/*
+// stops an animation on the current frame
+*/
+void lg_animation_stop(uint16_t index)
+{
+	((LG_ANIMATION*) lg_element_get_data(index))->playing = 0;
+}
+
+/*
+// checks if an animation is playing
+*/
+char lg_animation_is_playing(uint16_t index)
+{
+	return ((LG_ANIMATION*) lg_element_get_data(index))->playing;
+}
+
+/*
+// starts decoding the next frame if it's due
+*/
+static void lg_animation_next_frame(LG_ANIMATION* animation, uint32_t now)
+{
+	if (animation->starting)
+	{
+		animation->starting = 0;
+		animation->frame_time = now;
+	}
+	else
+	{
+		if (now - animation->frame_time < animation->period)
+			return;
+		animation->frame_time += animation->period;
+		/*
+		// if we fell behind by more than a frame don't try
+		// to catch up, just play the next frame now
+		*/
+		if (now - animation->frame_time >= animation->period)
+			animation->frame_time = now;
+	}
+	
+	if (animation->frame == animation->frame_count)
+	{
+		if (!animation->loop)
+		{
+			animation->playing = 0;
+			return;
+		}
+		lg_stream_seek(&animation->stream, LG_ANIMATION_HEADER_SIZE);
+		animation->frame = 0;
+	}
+	animation->rects_left = lg_stream_byte(&animation->stream);
+	animation->state = LG_ANIMATION_RECT;
+}
+
+/*
+// decodes pixels of the current rectangle into the frame buffer
+*/
+static uint16_t lg_animation_decode(LG_ANIMATION* animation, uint16_t budget)
+{
+	uint16_t decoded = 0;
+	unsigned char header;
+	LG_STREAM* stream = &animation->stream;
+	
+	while (decoded < budget && animation->row < animation->rect_height)
+	{
+		if (!animation->count)
+		{
+			header = lg_stream_byte(stream);
+			animation->repeat = (header & 0x80) != 0;
+			animation->count = (header & 0x7F) + 1;
+			if (animation->repeat)
+				animation->pixel = lg_stream_word(stream);
+		}
+		if (!animation->repeat)
+			animation->pixel = lg_stream_word(stream);
+		animation->count--;
+		/*
+		// pixels outside of the animation are dropped
+		*/
+		if (animation->rect_x + animation->col < animation->width && 
+			animation->rect_y + animation->row < animation->height)
+		{
+			animation->framebuffer[(uint32_t) (animation->rect_y + animation->row) * animation->width + 
+				animation->rect_x + animation->col] = animation->pixel;
+		}
+		if (++animation->col == animation->rect_width)
+		{
+			animation->col = 0;
+			animation->row++;
+		}
+		decoded++;
+	}
+	return decoded;
+}
+
+/*
+// advances all playing animations. At most LG_ANIMATION_BUDGET pixels
+// are decoded per call so a large frame is spread over several calls,
+// only the rectangles that change on each frame are repainted. Returns
+// non-zero while there's a frame being decoded
+*/
+char lg_animation_process(uint32_t now)
+{
+	int16_t i;
+	char busy = 0;
+	uint16_t budget = LG_ANIMATION_BUDGET;
+	LG_ANIMATION* animation;
+	
+	for (i = 0; i < LG_MAX_ANIMATIONS; i++)
+	{
+		animation = &animations[i];
+		if (!animation->in_use || !animation->playing)
+			continue;
+		
+		if (animation->state == LG_ANIMATION_IDLE)
+			lg_animation_next_frame(animation, now);
+		
+		while (budget && animation->state != LG_ANIMATION_IDLE)
+		{
+			if (animation->state == LG_ANIMATION_RECT)
+			{
+				if (!animation->rects_left)
+				{
+					animation->state = LG_ANIMATION_IDLE;
+					if (animation->frame++ == 0)
+						lg_element_set_visibility(animation->index, 1);
+					break;
+				}
+				animation->rects_left--;
+				animation->rect_x = lg_stream_word(&animation->stream);
+				animation->rect_y = lg_stream_word(&animation->stream);
+				animation->rect_width = lg_stream_word(&animation->stream);
+				animation->rect_height = lg_stream_word(&animation->stream);
+				/*
+				// an empty rectangle has no pixels, the decoder
+				// would never get to the end of it
+				*/
+				if (!animation->rect_width || !animation->rect_height)
+					continue;
+				animation->col = 0;
+				animation->row = 0;
+				animation->count = 0;
+				animation->state = LG_ANIMATION_PIXELS;
+			}
+			else
+			{
+				budget -= lg_animation_decode(animation, budget);
+				if (animation->row == animation->rect_height)
+				{
+					animation->state = LG_ANIMATION_RECT;
+					if (animation->rect_x < animation->width && animation->rect_y < animation->height)
+						lg_element_invalidate_rect(animation->index, 
+							animation->x + animation->rect_x, animation->y + animation->rect_y, 
+							MIN(animation->rect_width, animation->width - animation->rect_x), 
+							MIN(animation->rect_height, animation->height - animation->rect_y));
+				}
+			}
+		}
+		if (animation->state != LG_ANIMATION_IDLE)
+			busy = 1;
+	}
+	return busy;
+}
+
+/*
+// renders a span of an animation from it's frame buffer
+*/
+static void lg_animation_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span)
+{
+	LG_ANIMATION* animation = (LG_ANIMATION*) data;
+	uint16_t* pixels = &animation->framebuffer[(uint32_t) (y - animation->y) * animation->width + 
+		(x - animation->x)];
+	
+	while (width--)
+		*span++ = lg_rgb565(*pixels++);
+}
@@ -0,0 +1,314 @@
+/*
+ * lglib - Lightweight Graphics Library for Embedded Systems
+ * Copyright (C) 2013 Fernando Rodriguez (support@fernansoft.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+
+#include "font.h"
+#include "lg.h"
+#include "element.h"
+
+#define LG_MAX_BARS			4
+
+/*
+// no level set, the whole fill is drawn with the bar color
+*/
+#define LG_BAR_NO_LEVEL		0xFFFF
+
+typedef struct LG_BAR
+{
+	char in_use;
+	unsigned char flags;
+	int16_t index;
+	uint16_t x;
+	uint16_t y;
+	uint16_t width;
+	uint16_t height;
+	int16_t min;
+	int16_t max;
+	int16_t value;
+	uint16_t fill;
+	uint16_t level;
+	LG_RGB color;
+	LG_RGB level_color;
+	LG_RGB background;
+	unsigned char text_length;
+	uint16_t text_x;
+	uint16_t text_y;
+	char text[5];
+}
+LG_BAR;
+
+static LG_BAR bars[LG_MAX_BARS];
+
+/*
+// prototypes
+*/
+static void lg_bar_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span);
+static void lg_bar_release(void* data);
+
+static const LG_ELEMENT_OPS bar_ops = { lg_bar_render, lg_bar_release };
+
+/*
+// gets the length of a bar along it's fill direction
+*/
+#define LG_BAR_LENGTH(bar)		(((bar)->flags & LG_BAR_VERTICAL) ? (bar)->height : (bar)->width)
+
+/*
+// converts a value to the number of pixels it fills
+*/
+static uint16_t lg_bar_pixels(LG_BAR* bar, int16_t value)
+{
+	if (value <= bar->min)
+		return 0;
+	if (value >= bar->max)
+		return LG_BAR_LENGTH(bar);
+	return (uint16_t) ((((int32_t) value - bar->min) * LG_BAR_LENGTH(bar)) / ((int32_t) bar->max - bar->min));
+}
+
+/*
+// formats the percentage shown on a bar and centers it. If
+// it doesn't fit no text is shown
+*/
+static void lg_bar_format(LG_BAR* bar)
+{
+	unsigned char i = 0;
+	uint16_t percent;
+	
+	percent = (uint16_t) ((((int32_t) bar->value - bar->min) * 100) / ((int32_t) bar->max - bar->min));
+	if (percent >= 100)
+		bar->text[i++] = '1';
+	if (percent >= 10)
+		bar->text[i++] = '0' + (percent / 10) % 10;
+	bar->text[i++] = '0' + percent % 10;
+	bar->text[i++] = '%';
+	bar->text_length = i;
+	
+	if (bar->width < i * 8 || bar->height < 8)
+	{
+		bar->text_length = 0;
+		return;
+	}
+	bar->text_x = bar->x + (bar->width - i * 8) / 2;
+	bar->text_y = bar->y + (bar->height - 8) / 2;
+}
+
+/*
+// repaints the part of a bar between two fill positions
+*/
+static void lg_bar_invalidate_range(LG_BAR* bar, uint16_t from, uint16_t to)
+{
+	if (from == to)
+		return;
+	if (from > to)
+	{
+		uint16_t tmp = from;
+		from = to;
+		to = tmp;
+	}
+	if (bar->flags & LG_BAR_VERTICAL)
+		lg_element_invalidate_rect(bar->index, bar->x, bar->y + bar->height - to, bar->width, to - from);
+	else
+		lg_element_invalidate_rect(bar->index, bar->x + from, bar->y, to - from, bar->height);
+}
+
+/*
+// adds a bar to the display
+*/
+int16_t lg_bar_add(uint16_t x, uint16_t y, uint16_t width, uint16_t height, 
+	int16_t min, int16_t max, unsigned char flags, LG_RGB color, LG_RGB background)
+{
+	int16_t i;
+	for (i = 0; i < LG_MAX_BARS; i++)
+	{
+		if (!bars[i].in_use)
+		{
+			bars[i].x = x;
+			bars[i].y = y;
+			bars[i].width = width;
+			bars[i].height = height;
+			bars[i].min = min;
+			bars[i].max = (max > min) ? max : min + 1;
+			bars[i].value = min;
+			bars[i].fill = 0;
+			bars[i].level = LG_BAR_NO_LEVEL;
+			bars[i].flags = flags;
+			bars[i].color = color;
+			bars[i].level_color = color;
+			bars[i].background = background;
+			bars[i].text_length = 0;
+			if (flags & LG_BAR_PERCENT)
+				lg_bar_format(&bars[i]);
+			bars[i].index = lg_element_add(&bar_ops, &bars[i], LG_LAYER_CONTENT, x, y, width, height);
+			if (bars[i].index >= 0)
+				bars[i].in_use = 1;
+			return bars[i].index;
+		}
+	}
+	return -1;
+}
+
+/*
+// releases a bar
+*/
+static void lg_bar_release(void* data)
+{
+	((LG_BAR*) data)->in_use = 0;
+}
+
+/*
+// sets the value of a bar. Only the strip between the old and
+// new fill positions and the percentage text are repainted
+*/
+void lg_bar_set_value(uint16_t index, int16_t value)
+{
+	uint16_t fill;
+	unsigned char old_length;
+	uint16_t old_x;
+	LG_BAR* bar = (LG_BAR*) lg_element_get_data(index);
+	
+	if (value < bar->min)
+		value = bar->min;
+	if (value > bar->max)
+		value = bar->max;
+	if (value == bar->value)
+		return;
+	
+	bar->value = value;
+	fill = lg_bar_pixels(bar, value);
+	
+	lg_begin_update();
+	lg_bar_invalidate_range(bar, bar->fill, fill);
+	bar->fill = fill;
+	if (bar->flags & LG_BAR_PERCENT)
+	{
+		/*
+		// the text is centered so the widest one covers both
+		*/
+		old_length = bar->text_length;
+		old_x = bar->text_x;
+		lg_bar_format(bar);
+		if (old_length > bar->text_length)
+			lg_element_invalidate_rect(index, old_x, bar->text_y, old_length * 8, 8);
+		else if (bar->text_length)
+			lg_element_invalidate_rect(index, bar->text_x, bar->text_y, bar->text_length * 8, 8);
+	}
+	lg_end_update();
+}
+
+/*
+// gets the value of a bar
+*/
+int16_t lg_bar_get_value(uint16_t index)
+{
+	return ((LG_BAR*) lg_element_get_data(index))->value;
+}
+
+/*
+// sets the value above which the fill of a bar is drawn in
+// a different color
+*/
+void lg_bar_set_level(uint16_t index, int16_t value, LG_RGB color)
+{
+	uint16_t level;
+	LG_BAR* bar = (LG_BAR*) lg_element_get_data(index);
+	
+	level = lg_bar_pixels(bar, value);
+	if (level == bar->level && color == bar->level_color)
+		return;
+	/*
+	// only the filled part past the lowest of the two
+	// levels can change
+	*/
+	if (color != bar->level_color)
+		lg_bar_invalidate_range(bar, MIN(level, MIN(bar->level, bar->fill)), bar->fill);
+	else
+		lg_bar_invalidate_range(bar, MIN(level, bar->fill), MIN(bar->level, bar->fill));
+	bar->level = level;
+	bar->level_color = color;
+}
+
+/*
+// fills part of a span with a color
+*/
+static void lg_bar_run(LG_RGB* span, uint16_t from, uint16_t to, LG_RGB color)
+{
+	while (from < to)
+		span[from++] = color;
+}
+
+/*
+// renders a span of a bar. Each row of a horizontal bar is at
+// most three solid runs and each row of a vertical bar is one
+*/
+static void lg_bar_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span)
+{
+	uint16_t i;
+	uint16_t pos;
+	uint16_t fill;
+	uint16_t level;
+	uint16_t column;
+	uint16_t end;
+	unsigned char font_row;
+	unsigned char c;
+	LG_BAR* bar = (LG_BAR*) data;
+	
+	if (bar->flags & LG_BAR_VERTICAL)
+	{
+		pos = bar->height - 1 - (y - bar->y);
+		if (pos >= bar->fill)
+			lg_bar_run(span, 0, width, bar->background);
+		else if (pos >= bar->level)
+			lg_bar_run(span, 0, width, bar->level_color);
+		else
+			lg_bar_run(span, 0, width, bar->color);
+	}
+	else
+	{
+		/*
+		// find where the fill and level end on the span
+		*/
+		pos = x - bar->x;
+		fill = (bar->fill > pos) ? MIN(bar->fill - pos, width) : 0;
+		level = (bar->level > pos) ? MIN(bar->level - pos, fill) : 0;
+		lg_bar_run(span, 0, level, bar->color);
+		lg_bar_run(span, level, fill, bar->level_color);
+		lg_bar_run(span, fill, width, bar->background);
+	}
+	
+	/*
+	// the text is drawn with the background color over the
+	// fill and with the bar color over the background
+	*/
+	if (bar->text_length && y >= bar->text_y && y < bar->text_y + 8 && 
+		x < bar->text_x + bar->text_length * 8 && x + width > bar->text_x)
+	{
+		font_row = y - bar->text_y;
+		i = (x > bar->text_x) ? x - bar->text_x : 0;
+		end = MIN(x + width - bar->text_x, bar->text_length * 8);
+		for (; i < end; i++)
+		{
+			c = (unsigned char) bar->text[i >> 3];
+			if (LG_GLYPH_PIXEL(c, font_row, i & 7))
+			{
+				column = bar->text_x + i - x;
+				span[column] = (span[column] == bar->background) ? bar->color : bar->background;
+			}
+		}
+	}
+}
@@ -0,0 +1,255 @@
+/*
+ * lglib - Lightweight Graphics Library for Embedded Systems
+ * Copyright (C) 2013 Fernando Rodriguez (support@fernansoft.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "lg.h"
+#include "element.h"
+
+#define LG_MAX_CHARTS		4
+
+typedef struct LG_CHART
+{
+	char in_use;
+	unsigned char mode;
+	int16_t index;
+	uint16_t x;
+	uint16_t y;
+	uint16_t width;
+	uint16_t height;
+	int16_t min;
+	int16_t max;
+	LG_RGB color;
+	LG_RGB background;
+	unsigned char* samples;
+	uint16_t head;
+	uint16_t count;
+}
+LG_CHART;
+
+static LG_CHART charts[LG_MAX_CHARTS];
+
+/*
+// prototypes
+*/
+static void lg_chart_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span);
+static void lg_chart_release(void* data);
+
+static const LG_ELEMENT_OPS chart_ops = { lg_chart_render, lg_chart_release };
+
+/*
+// adds a chart to the display
+*/
+int16_t lg_chart_add(unsigned char* samples, uint16_t x, uint16_t y, uint16_t width, uint16_t height, 
+	int16_t min, int16_t max, unsigned char mode, LG_RGB color, LG_RGB background)
+{
+	int16_t i;
+	for (i = 0; i < LG_MAX_CHARTS; i++)
+	{
+		if (!charts[i].in_use)
+		{
+			charts[i].samples = samples;
+			charts[i].x = x;
+			charts[i].y = y;
+			charts[i].width = width;
+			charts[i].height = MIN(height, 256);
+			charts[i].min = min;
+			charts[i].max = (max > min) ? max : min + 1;
+			charts[i].mode = mode;
+			charts[i].color = color;
+			charts[i].background = background;
+			charts[i].head = 0;
+			charts[i].count = 0;
+			charts[i].index = lg_element_add(&chart_ops, &charts[i], LG_LAYER_CONTENT, 
+				x, y, width, charts[i].height);
+			if (charts[i].index >= 0)
+				charts[i].in_use = 1;
+			return charts[i].index;
+		}
+	}
+	return -1;
+}
+
+/*
+// releases a chart
+*/
+static void lg_chart_release(void* data)
+{
+	((LG_CHART*) data)->in_use = 0;
+}
+
+/*
+// repaints a range of columns of a chart, wrapping around
+// the right edge
+*/
+static void lg_chart_invalidate_columns(LG_CHART* chart, uint16_t column, uint16_t count)
+{
+	uint16_t n;
+	
+	while (count)
+	{
+		if (column >= chart->width)
+			column -= chart->width;
+		n = MIN(count, chart->width - column);
+		lg_element_invalidate_rect(chart->index, chart->x + column, chart->y, n, chart->height);
+		column += n;
+		count -= n;
+	}
+}
+
+/*
+// adds a sample to a chart
+*/
+void lg_chart_add_sample(uint16_t index, int16_t value)
+{
+	uint16_t column;
+	LG_CHART* chart = (LG_CHART*) lg_element_get_data(index);
+	
+	/*
+	// samples are stored as the row where they are drawn
+	*/
+	if (value < chart->min)
+		value = chart->min;
+	if (value > chart->max)
+		value = chart->max;
+	column = chart->head;
+	chart->samples[column] = (unsigned char) ((chart->height - 1) -
+		(((int32_t) value - chart->min) * (chart->height - 1)) / ((int32_t) chart->max - chart->min));
+	if (++chart->head == chart->width)
+		chart->head = 0;
+	
+	if (chart->count < chart->width)
+	{
+		/*
+		// until the chart fills up both modes draw the samples left
+		// to right so only the new column changes
+		*/
+		chart->count++;
+		if (chart->mode == LG_CHART_SWEEP && chart->count == chart->width)
+		{
+			lg_begin_update();
+			lg_chart_invalidate_columns(chart, column, 3);
+			lg_end_update();
+		}
+		else
+		{
+			lg_chart_invalidate_columns(chart, column, 1);
+		}
+	}
+	else if (chart->mode == LG_CHART_SWEEP)
+	{
+		/*
+		// the sample replaces the oldest one, the gap that marks the
+		// sweep position moves to the next column and the column after
+		// the gap is no longer joined to it's left
+		*/
+		lg_begin_update();
+		lg_chart_invalidate_columns(chart, column, 3);
+		lg_end_update();
+	}
+	else
+	{
+		/*
+		// all samples move one column to the left, if the display can
+		// scroll the chart we only need to draw the new sample and
+		// the first column which is no longer joined to it's left
+		*/
+		if (lg_element_scroll(index, -1, 0))
+		{
+			lg_begin_update();
+			lg_chart_invalidate_columns(chart, chart->width - 1, 2);
+			lg_end_update();
+		}
+		else
+		{
+			lg_element_invalidate(index);
+		}
+	}
+}
+
+/*
+// removes all samples from a chart
+*/
+void lg_chart_clear(uint16_t index)
+{
+	LG_CHART* chart = (LG_CHART*) lg_element_get_data(index);
+	chart->head = 0;
+	chart->count = 0;
+	lg_element_invalidate(index);
+}
+
+/*
+// renders a span of a chart. Each column is drawn as a vertical
+// span from the previous sample to it's own so the samples are
+// joined
+*/
+static void lg_chart_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span)
+{
+	uint16_t i;
+	uint16_t column;
+	uint16_t sample;
+	uint16_t gap = 0xFFFF;
+	unsigned char row;
+	unsigned char value;
+	unsigned char prev;
+	LG_CHART* chart = (LG_CHART*) data;
+	
+	row = (unsigned char) (y - chart->y);
+	column = x - chart->x;
+	sample = column;
+	
+	/*
+	// once the chart is full the sweep mode leaves a blank column 
+	// after the newest sample and the scroll mode draws the oldest
+	// sample on the first column
+	*/
+	if (chart->count == chart->width)
+	{
+		if (chart->mode == LG_CHART_SWEEP)
+		{
+			gap = chart->head;
+		}
+		else
+		{
+			sample += chart->head;
+			if (sample >= chart->width)
+				sample -= chart->width;
+		}
+	}
+	
+	for (i = 0; i < width; i++, column++)
+	{
+		if (column >= chart->count || column == gap)
+		{
+			span[i] = chart->background;
+		}
+		else
+		{
+			value = chart->samples[sample];
+			prev = value;
+			if (column && column != gap + 1)
+				prev = chart->samples[sample ? sample - 1 : chart->width - 1];
+			if ((row >= value && row <= prev) || (row >= prev && row <= value))
+				span[i] = chart->color;
+			else
+				span[i] = chart->background;
+		}
+		if (++sample == chart->width)
+			sample = 0;
+	}
+}
@@ -50,6 +50,8 @@ typedef unsigned int uintptr_t;
 typedef int int16_t;
 typedef long int32_t;
 #define NO_INT64
+#elif defined(__GNUC__)
+#include <stdint.h>
 #else
 typedef unsigned short uint16_t;
 typedef unsigned long uint32_t;
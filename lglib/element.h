@@ -0,0 +1,264 @@
+/*
+ * lglib - Lightweight Graphics Library for Embedded Systems
+ * Copyright (C) 2013 Fernando Rodriguez (support@fernansoft.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef ELEMENT_H
+#define ELEMENT_H
+
+#include "lg.h"
+#include "font.h"
+
+#if !defined(MIN)
+#define MIN(a, b)			(((a) < (b)) ? (a) : (b))
+#define MAX(a, b)			(((a) > (b)) ? (a) : (b))
+#endif
+
+/*
+// gets a row of the glyph of a character and tests a pixel of it, the
+// leftmost pixel is column 0. Characters that are not on the font are
+// blank
+*/
+#define LG_GLYPH_ROW(c, row)			(((unsigned char) (c) < 127) ? font[(unsigned char) (c)][row] : 0)
+#define LG_GLYPH_PIXEL(c, row, column)	((LG_GLYPH_ROW(c, row) << (column)) & 0x80)
+
+/*
+// renders the pixels of an element that fall on the span [x, x + width)
+// of scanline y. The span is always clipped to the element bounds, pixels
+// not covered by the element must be left untouched.
+*/
+typedef void (*LG_ELEMENT_RENDER)(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span);
+
+/*
+// releases the type specific data of an element when it is removed
+*/
+typedef void (*LG_ELEMENT_RELEASE)(void* data);
+
+typedef struct LG_ELEMENT_OPS
+{
+	LG_ELEMENT_RENDER render;
+	LG_ELEMENT_RELEASE release;
+}
+LG_ELEMENT_OPS;
+
+/**
+ * <summary>Adds an element to the display.</summary>
+ */
+int16_t lg_element_add
+(
+	const LG_ELEMENT_OPS* ops, 
+	void* data, 
+	unsigned char layer, 
+	uint16_t x, 
+	uint16_t y, 
+	uint16_t width, 
+	uint16_t height
+);
+
+/**
+ * <summary>Gets the type specific data of an element.</summary>
+ */
+void* lg_element_get_data
+(
+	uint16_t index
+);
+
+/**
+ * <summary>Updates the bounds of an element and repaints the old and new areas.</summary>
+ */
+void lg_element_set_bounds
+(
+	uint16_t index, 
+	uint16_t x, 
+	uint16_t y, 
+	uint16_t width, 
+	uint16_t height
+);
+
+/**
+ * <summary>Updates the bounds of an element without repainting it. The caller
+ * is responsible for repainting any area that changes.</summary>
+ */
+void lg_element_update_bounds
+(
+	uint16_t index, 
+	uint16_t x, 
+	uint16_t y, 
+	uint16_t width, 
+	uint16_t height
+);
+
+/**
+ * <summary>Repaints an element.</summary>
+ */
+void lg_element_invalidate
+(
+	uint16_t index
+);
+
+/**
+ * <summary>Repaints a region of an element.</summary>
+ */
+void lg_element_invalidate_rect
+(
+	uint16_t index, 
+	uint16_t x, 
+	uint16_t y, 
+	uint16_t width, 
+	uint16_t height
+);
+
+/*
+// decoder position within a compressed bitmap
+*/
+typedef struct LG_RLE_CURSOR
+{
+	uint16_t row;
+	uint32_t offset;
+	unsigned char count;
+	char repeat;
+	LG_RGB pixel;
+}
+LG_RLE_CURSOR;
+
+/**
+ * <summary>Repaints the old and new areas of something that moved within
+ * an element. Overlapping areas are repainted once.</summary>
+ */
+void lg_element_invalidate_move
+(
+	uint16_t index, 
+	uint16_t old_x, 
+	uint16_t old_y, 
+	uint16_t old_width, 
+	uint16_t old_height, 
+	uint16_t x, 
+	uint16_t y, 
+	uint16_t width, 
+	uint16_t height
+);
+
+/**
+ * <summary>Scrolls the contents of an element on the display by dx pixels
+ * horizontally and dy pixels vertically. Returns 0 if another element 
+ * overlaps it or the display cannot scroll it, in which case it must be
+ * repainted.</summary>
+ */
+char lg_element_scroll
+(
+	uint16_t index, 
+	int16_t dx, 
+	int16_t dy
+);
+
+/**
+ * <summary>Blends a color over a pixel with the given coverage (0 - 255).</summary>
+ */
+LG_RGB lg_blend
+(
+	LG_RGB pixel, 
+	LG_RGB color, 
+	unsigned char alpha
+);
+
+/**
+ * <summary>Integer square root.</summary>
+ */
+uint16_t lg_isqrt
+(
+	uint32_t value
+);
+
+/**
+ * <summary>Converts an RGB565 pixel.</summary>
+ */
+LG_RGB lg_rgb565
+(
+	uint16_t pixel
+);
+
+/**
+ * <summary>Rewinds the decoder of a compressed bitmap.</summary>
+ */
+void lg_bitmap_rewind
+(
+	LG_RLE_CURSOR* cursor
+);
+
+/**
+ * <summary>Renders a span of a bitmap starting at column col of the
+ * specified row. If transparent is set pixels with palette index 0
+ * are left untouched.</summary>
+ */
+void lg_bitmap_render
+(
+	const LG_BITMAP* bitmap, 
+	LG_RLE_CURSOR* cursor, 
+	uint16_t col, 
+	uint16_t row, 
+	uint16_t width, 
+	char transparent, 
+	LG_RGB* span
+);
+
+/**
+ * <summary>Opens a stream in memory.</summary>
+ */
+void lg_stream_open_memory
+(
+	LG_STREAM* stream, 
+	const unsigned char* data, 
+	uint32_t size
+);
+
+/**
+ * <summary>Opens a stream that is read through a callback.</summary>
+ */
+void lg_stream_open
+(
+	LG_STREAM* stream, 
+	LG_STREAM_READ read, 
+	void* context
+);
+
+/**
+ * <summary>Moves a stream to an offset.</summary>
+ */
+void lg_stream_seek
+(
+	LG_STREAM* stream, 
+	uint32_t offset
+);
+
+/**
+ * <summary>Reads the next byte of a stream.</summary>
+ */
+unsigned char lg_stream_byte
+(
+	LG_STREAM* stream
+);
+
+/**
+ * <summary>Reads a 16 bit little endian value from a stream.</summary>
+ */
+uint16_t lg_stream_word
+(
+	LG_STREAM* stream
+);
+
+#endif
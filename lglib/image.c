@@ -0,0 +1,268 @@
+/*
+ * lglib - Lightweight Graphics Library for Embedded Systems
+ * Copyright (C) 2013 Fernando Rodriguez (support@fernansoft.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "lg.h"
+#include "element.h"
+
+#define LG_MAX_IMAGES		8
+
+/*
+// RLE packet header bits
+*/
+#define LG_RLE_REPEAT		0x80
+#define LG_RLE_COUNT_MASK	0x7F
+
+typedef struct LG_IMAGE
+{
+	char in_use;
+	char transparent;
+	int16_t index;
+	uint16_t x;
+	uint16_t y;
+	const LG_BITMAP* bitmap;
+	LG_RLE_CURSOR cursor;
+}
+LG_IMAGE;
+
+static LG_IMAGE images[LG_MAX_IMAGES];
+
+/*
+// prototypes
+*/
+static void lg_image_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span);
+static void lg_image_release(void* data);
+
+static const LG_ELEMENT_OPS image_ops = { lg_image_render, lg_image_release };
+
+/*
+// converts an RGB565 pixel from it's two bytes
+*/
+#define LG_RGB565(lo, hi)	lg_rgb565((lo) | ((uint16_t) (hi) << 8))
+
+/*
+// rewinds the decoder of a compressed bitmap
+*/
+void lg_bitmap_rewind(LG_RLE_CURSOR* cursor)
+{
+	cursor->row = 0;
+	cursor->offset = 0;
+	cursor->count = 0;
+}
+
+/*
+// adds an image to the display
+*/
+int16_t lg_image_add(const LG_BITMAP* bitmap, uint16_t x, uint16_t y, char transparent)
+{
+	int16_t i;
+	for (i = 0; i < LG_MAX_IMAGES; i++)
+	{
+		if (!images[i].in_use)
+		{
+			images[i].bitmap = bitmap;
+			images[i].x = x;
+			images[i].y = y;
+			images[i].transparent = transparent;
+			lg_bitmap_rewind(&images[i].cursor);
+			images[i].index = lg_element_add(&image_ops, &images[i], LG_LAYER_CONTENT, 
+				x, y, bitmap->width, bitmap->height);
+			if (images[i].index >= 0)
+				images[i].in_use = 1;
+			return images[i].index;
+		}
+	}
+	return -1;
+}
+
+/*
+// releases an image
+*/
+static void lg_image_release(void* data)
+{
+	((LG_IMAGE*) data)->in_use = 0;
+}
+
+/*
+// moves an image
+*/
+void lg_image_set_position(uint16_t index, uint16_t x, uint16_t y)
+{
+	LG_IMAGE* image = (LG_IMAGE*) lg_element_get_data(index);
+	image->x = x;
+	image->y = y;
+	lg_element_set_bounds(index, x, y, image->bitmap->width, image->bitmap->height);
+}
+
+/*
+// changes the bitmap of an image
+*/
+void lg_image_set_bitmap(uint16_t index, const LG_BITMAP* bitmap)
+{
+	LG_IMAGE* image = (LG_IMAGE*) lg_element_get_data(index);
+	if (image->bitmap != bitmap)
+	{
+		image->bitmap = bitmap;
+		lg_bitmap_rewind(&image->cursor);
+		lg_element_set_bounds(index, image->x, image->y, bitmap->width, bitmap->height);
+	}
+}
+
+/*
+// decodes the next pixel of a compressed image
+*/
+static LG_RGB lg_rle_next(LG_RLE_CURSOR* cursor, const unsigned char* data)
+{
+	if (!cursor->count)
+	{
+		cursor->repeat = (data[cursor->offset] & LG_RLE_REPEAT) != 0;
+		cursor->count = (data[cursor->offset] & LG_RLE_COUNT_MASK) + 1;
+		cursor->offset++;
+		if (cursor->repeat)
+		{
+			cursor->pixel = LG_RGB565(data[cursor->offset], data[cursor->offset + 1]);
+			cursor->offset += 2;
+		}
+	}
+	cursor->count--;
+	if (!cursor->repeat)
+	{
+		cursor->pixel = LG_RGB565(data[cursor->offset], data[cursor->offset + 1]);
+		cursor->offset += 2;
+	}
+	return cursor->pixel;
+}
+
+/*
+// skips pixels of a compressed image, whole runs are skipped
+// without decoding their pixels
+*/
+static void lg_rle_skip(LG_RLE_CURSOR* cursor, const unsigned char* data, uint16_t pixels)
+{
+	unsigned char n;
+	
+	while (pixels)
+	{
+		if (!cursor->count)
+		{
+			cursor->repeat = (data[cursor->offset] & LG_RLE_REPEAT) != 0;
+			cursor->count = (data[cursor->offset] & LG_RLE_COUNT_MASK) + 1;
+			cursor->offset++;
+			if (cursor->repeat)
+			{
+				cursor->pixel = LG_RGB565(data[cursor->offset], data[cursor->offset + 1]);
+				cursor->offset += 2;
+			}
+		}
+		n = (unsigned char) MIN(pixels, cursor->count);
+		cursor->count -= n;
+		pixels -= n;
+		if (!cursor->repeat)
+			cursor->offset += (uint16_t) n * 2;
+	}
+}
+
+/*
+// renders a span of a compressed bitmap. The cursor is kept at the
+// start of the last row rendered so when rows are rendered in order
+// we only decode each row once
+*/
+static void lg_bitmap_render_rle(const LG_BITMAP* bitmap, LG_RLE_CURSOR* rle, 
+	uint16_t col, uint16_t row, uint16_t width, LG_RGB* span)
+{
+	uint16_t i;
+	LG_RLE_CURSOR cursor;
+	
+	if (row < rle->row)
+		lg_bitmap_rewind(rle);
+	
+	while (rle->row < row)
+	{
+		lg_rle_skip(rle, bitmap->data, bitmap->width);
+		rle->row++;
+	}
+	
+	cursor = *rle;
+	lg_rle_skip(&cursor, bitmap->data, col);
+	for (i = 0; i < width; i++)
+		span[i] = lg_rle_next(&cursor, bitmap->data);
+	/*
+	// if we decoded the whole row move the cursor to the next one
+	*/
+	if (col + width == bitmap->width)
+	{
+		*rle = cursor;
+		rle->row++;
+	}
+}
+
+/*
+// renders a span of a bitmap starting at column col of the
+// specified row
+*/
+void lg_bitmap_render(const LG_BITMAP* bitmap, LG_RLE_CURSOR* cursor, 
+	uint16_t col, uint16_t row, uint16_t width, char transparent, LG_RGB* span)
+{
+	uint16_t i;
+	unsigned char value;
+	const unsigned char* data;
+	
+	switch (bitmap->format)
+	{
+		case LG_BITMAP_1BPP:
+			data = &bitmap->data[(uint32_t) row * ((bitmap->width + 7) >> 3)];
+			for (i = 0; i < width; i++, col++)
+			{
+				value = (data[col >> 3] >> (7 - (col & 7))) & 1;
+				if (value || !transparent)
+					span[i] = bitmap->palette[value];
+			}
+			break;
+			
+		case LG_BITMAP_4BPP:
+			data = &bitmap->data[(uint32_t) row * ((bitmap->width + 1) >> 1)];
+			for (i = 0; i < width; i++, col++)
+			{
+				value = (col & 1) ? (data[col >> 1] & 0x0F) : (data[col >> 1] >> 4);
+				if (value || !transparent)
+					span[i] = bitmap->palette[value];
+			}
+			break;
+			
+		case LG_BITMAP_RGB565:
+			data = &bitmap->data[((uint32_t) row * bitmap->width + col) * 2];
+			for (i = 0; i < width; i++, data += 2)
+				span[i] = LG_RGB565(data[0], data[1]);
+			break;
+			
+		case LG_BITMAP_RLE:
+			lg_bitmap_render_rle(bitmap, cursor, col, row, width, span);
+			break;
+	}
+}
+
+/*
+// renders a span of an image
+*/
+static void lg_image_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span)
+{
+	LG_IMAGE* image = (LG_IMAGE*) data;
+	lg_bitmap_render(image->bitmap, &image->cursor, 
+		x - image->x, y - image->y, width, image->transparent, span);
+}
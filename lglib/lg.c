@@ -21,13 +21,52 @@
 #include "font.h"
 #include <string.h>
 #include "lg.h"
+#include "element.h"
 
 #define LG_MAX_STRINGS		10
+#define LG_MAX_ELEMENTS		32
+#define LG_MAX_CACHE_ROWS	240
+#define LG_MAX_DAMAGE		8
+
+typedef struct LG_ELEMENT
+{
+	const LG_ELEMENT_OPS* ops;
+	void* data;
+	char in_use;
+	char visible;
+	unsigned char layer;
+	signed char z;
+	uint16_t x;
+	uint16_t y;
+	uint16_t width;
+	uint16_t height;
+}
+LG_ELEMENT;
+
+typedef struct LG_LAYER_CACHE
+{
+	LG_RGB* buffer;
+	unsigned char layer;
+	uint16_t x;
+	uint16_t y;
+	uint16_t width;
+	uint16_t height;
+	unsigned char valid[(LG_MAX_CACHE_ROWS + 7) / 8];
+}
+LG_LAYER_CACHE;
+
+typedef struct LG_RECT
+{
+	uint16_t x;
+	uint16_t y;
+	uint16_t width;
+	uint16_t height;
+}
+LG_RECT;
 
 typedef struct LG_LABEL
 {
 	unsigned char* string;
-	char visible;
 	char in_use;
 	unsigned char size;
 	unsigned char spacing;
@@ -41,13 +80,25 @@ LG_LABEL;
 
 LG_LABEL labels[LG_MAX_STRINGS];
 LG_RGB background;
+static LG_ELEMENT elements[LG_MAX_ELEMENTS];
+static unsigned char draw_order[LG_MAX_ELEMENTS];
+static unsigned char draw_count;
+static LG_LAYER_CACHE cache;
 static LG_DISPLAY_PAINT paint;
 static LG_DISPLAY_PAINT_PARTIAL paint_partial;
+static LG_DISPLAY_BUSY display_busy;
+static LG_DISPLAY_SCROLL display_scroll;
+static LG_RECT damage[LG_MAX_DAMAGE];
+static unsigned char damage_count;
+static unsigned char update_depth;
 
 /*
 // prototypes
 */
-LG_RGB lg_get_string_pixel(LG_LABEL str, uint16_t x, uint16_t y, LG_RGB background);
+static void lg_label_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span);
+static void lg_label_release(void* data);
+
+static const LG_ELEMENT_OPS label_ops = { lg_label_render, lg_label_release };
 
 /*
 // initializes the lite gui library
@@ -58,12 +109,479 @@ void lg_init(LG_DISPLAY_PAINT display_paint, LG_DISPLAY_PAINT_PARTIAL display_pa
 	paint_partial = display_paint_partial;	
 }
 
+/*
+// sets the function used to check if the display is
+// still busy painting
+*/
+void lg_set_busy_callback(LG_DISPLAY_BUSY busy)
+{
+	display_busy = busy;
+}
+
+/*
+// checks if the display is still busy painting
+*/
+char lg_display_is_busy(void)
+{
+	return (display_busy != NULL) ? display_busy() : 0;
+}
+
+/*
+// sets the function used to scroll a region of the display
+*/
+void lg_set_scroll_callback(LG_DISPLAY_SCROLL scroll)
+{
+	display_scroll = scroll;
+}
+
+/*
+// adds a region to the damage list of the current update. If the
+// union with a listed region is not larger than both regions combined
+// they are merged, if the list is full the region is merged with the
+// one that grows the least
+*/
+static void lg_damage_add(uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+	unsigned char i;
+	unsigned char best = 0;
+	uint16_t union_x;
+	uint16_t union_y;
+	uint32_t area;
+	uint32_t growth;
+	uint32_t best_growth = 0xFFFFFFFF;
+	LG_RECT* r;
+	
+	for (i = 0; i < damage_count; i++)
+	{
+		r = &damage[i];
+		union_x = MIN(r->x, x);
+		union_y = MIN(r->y, y);
+		area = (uint32_t) (MAX(r->x + r->width, x + width) - union_x) *
+			(MAX(r->y + r->height, y + height) - union_y);
+		growth = area - (uint32_t) r->width * r->height;
+		if (area <= (uint32_t) r->width * r->height + (uint32_t) width * height)
+		{
+			best = i;
+			best_growth = 0;
+			break;
+		}
+		if (growth < best_growth)
+		{
+			best = i;
+			best_growth = growth;
+		}
+	}
+	if (best_growth && damage_count < LG_MAX_DAMAGE)
+	{
+		damage[damage_count].x = x;
+		damage[damage_count].y = y;
+		damage[damage_count].width = width;
+		damage[damage_count].height = height;
+		damage_count++;
+		return;
+	}
+	r = &damage[best];
+	union_x = MIN(r->x, x);
+	union_y = MIN(r->y, y);
+	r->width = MAX(r->x + r->width, x + width) - union_x;
+	r->height = MAX(r->y + r->height, y + height) - union_y;
+	r->x = union_x;
+	r->y = union_y;
+}
+
+/*
+// starts a batch of changes, the display is not repainted
+// until the batch ends
+*/
+void lg_begin_update(void)
+{
+	update_depth++;
+}
+
+/*
+// ends a batch of changes and repaints the merged damage
+*/
+void lg_end_update(void)
+{
+	unsigned char i;
+	
+	if (!update_depth || --update_depth)
+		return;
+	
+	for (i = 0; i < damage_count; i++)
+		paint_partial(damage[i].x, damage[i].y, damage[i].width, damage[i].height);
+	damage_count = 0;
+}
+
+/*
+// invalidates a region of the screen that contains elements
+// of the specified layer
+*/
+static void lg_invalidate(unsigned char layer, uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+	uint16_t row;
+	uint16_t row_end;
+	
+	if (!width || !height)
+		return;
+	/*
+	// if the region overlaps the cached area and the layer is
+	// cached drop the affected rows from the cache
+	*/
+	if (cache.buffer != NULL && layer <= cache.layer &&
+		x < cache.x + cache.width && x + width > cache.x &&
+		y < cache.y + cache.height && y + height > cache.y)
+	{
+		row = (y > cache.y) ? y - cache.y : 0;
+		row_end = MIN(y + height - cache.y, cache.height);
+		for (; row < row_end; row++)
+			cache.valid[row >> 3] &= ~(1 << (row & 7));
+	}
+	if (update_depth)
+		lg_damage_add(x, y, width, height);
+	else
+		paint_partial(x, y, width, height);
+}
+
+/*
+// invalidates the old and new areas of something that moved or
+// changed size. If the union of both areas is not larger than the
+// two areas combined (ie. they overlap or a label grows or shrinks)
+// we repaint the union once, otherwise we repaint each area
+*/
+static void lg_invalidate_move(unsigned char layer, 
+	uint16_t old_x, uint16_t old_y, uint16_t old_width, uint16_t old_height,
+	uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+	uint16_t union_x;
+	uint16_t union_y;
+	uint16_t union_width;
+	uint16_t union_height;
+	
+	if (!old_width || !old_height)
+	{
+		lg_invalidate(layer, x, y, width, height);
+		return;
+	}
+	if (!width || !height)
+	{
+		lg_invalidate(layer, old_x, old_y, old_width, old_height);
+		return;
+	}
+	
+	union_x = MIN(old_x, x);
+	union_y = MIN(old_y, y);
+	union_width = MAX(old_x + old_width, x + width) - union_x;
+	union_height = MAX(old_y + old_height, y + height) - union_y;
+	
+	if ((uint32_t) union_width * union_height <= 
+		(uint32_t) old_width * old_height + (uint32_t) width * height)
+	{
+		lg_invalidate(layer, union_x, union_y, union_width, union_height);
+	}
+	else
+	{
+		lg_invalidate(layer, old_x, old_y, old_width, old_height);
+		lg_invalidate(layer, x, y, width, height);
+	}
+}
+
+/*
+// blends a color over a pixel with the given coverage (0 - 255)
+*/
+LG_RGB lg_blend(LG_RGB pixel, LG_RGB color, unsigned char alpha)
+{
+	uint16_t a;
+	uint16_t r;
+	uint16_t g;
+	uint16_t b;
+	
+	if (alpha == 0xFF)
+		return color;
+	if (alpha == 0)
+		return pixel;
+	
+	a = alpha + (alpha >> 7);
+	r = ((((color >> 16) & 0xFF) * a) + (((pixel >> 16) & 0xFF) * (256 - a))) >> 8;
+	g = ((((color >> 8) & 0xFF) * a) + (((pixel >> 8) & 0xFF) * (256 - a))) >> 8;
+	b = (((color & 0xFF) * a) + ((pixel & 0xFF) * (256 - a))) >> 8;
+	return ((LG_RGB) r << 16) | ((LG_RGB) g << 8) | b;
+}
+
+/*
+// converts an RGB565 pixel
+*/
+LG_RGB lg_rgb565(uint16_t pixel)
+{
+	LG_RGB r = (pixel >> 11) & 0x1F;
+	LG_RGB g = (pixel >> 5) & 0x3F;
+	LG_RGB b = pixel & 0x1F;
+	return (((r << 3) | (r >> 2)) << 16) | (((g << 2) | (g >> 4)) << 8) | ((b << 3) | (b >> 2));
+}
+
+/*
+// inserts an element on the draw list after all other elements
+// on the same layer and z-order
+*/
+static void lg_order_insert(unsigned char index)
+{
+	unsigned char i;
+	unsigned char pos = draw_count;
+	
+	for (i = 0; i < draw_count; i++)
+	{
+		if (elements[draw_order[i]].layer > elements[index].layer ||
+			(elements[draw_order[i]].layer == elements[index].layer && 
+			elements[draw_order[i]].z > elements[index].z))
+		{
+			pos = i;
+			break;
+		}
+	}
+	for (i = draw_count; i > pos; i--)
+		draw_order[i] = draw_order[i - 1];
+	draw_order[pos] = index;
+	draw_count++;
+}
+
+/*
+// removes an element from the draw list
+*/
+static void lg_order_remove(unsigned char index)
+{
+	unsigned char i;
+	
+	for (i = 0; i < draw_count; i++)
+	{
+		if (draw_order[i] == index)
+		{
+			draw_count--;
+			for (; i < draw_count; i++)
+				draw_order[i] = draw_order[i + 1];
+			break;
+		}
+	}
+}
+
+/*
+// adds an element to the display
+*/
+int16_t lg_element_add(const LG_ELEMENT_OPS* ops, void* data, unsigned char layer, 
+	uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+	int16_t i;
+	for (i = 0; i < LG_MAX_ELEMENTS; i++)
+	{
+		if (!elements[i].in_use)
+		{
+			elements[i].ops = ops;
+			elements[i].data = data;
+			elements[i].layer = layer;
+			elements[i].z = 0;
+			elements[i].x = x;
+			elements[i].y = y;
+			elements[i].width = width;
+			elements[i].height = height;
+			elements[i].visible = 1;
+			elements[i].in_use = 1;
+			lg_order_insert(i);
+			lg_invalidate(layer, x, y, width, height);
+			return i;
+		}
+	}
+	return -1;
+}
+
+/*
+// gets the type specific data of an element
+*/
+void* lg_element_get_data(uint16_t index)
+{
+	return elements[index].data;
+}
+
+/*
+// repaints a region of an element
+*/
+void lg_element_invalidate_rect(uint16_t index, uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+	if (elements[index].visible)
+		lg_invalidate(elements[index].layer, x, y, width, height);
+}
+
+/*
+// repaints an element
+*/
+void lg_element_invalidate(uint16_t index)
+{
+	lg_element_invalidate_rect(index, elements[index].x, elements[index].y, 
+		elements[index].width, elements[index].height);
+}
+
+/*
+// repaints the old and new areas of something that moved
+// within an element
+*/
+void lg_element_invalidate_move(uint16_t index, 
+	uint16_t old_x, uint16_t old_y, uint16_t old_width, uint16_t old_height,
+	uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+	if (elements[index].visible)
+	{
+		lg_invalidate_move(elements[index].layer, 
+			old_x, old_y, old_width, old_height, x, y, width, height);
+	}
+}
+
+/*
+// scrolls the contents of an element on the display. This is
+// only possible if no other visible element overlaps it and the
+// display can scroll that region
+*/
+char lg_element_scroll(uint16_t index, int16_t dx, int16_t dy)
+{
+	unsigned char i;
+	LG_ELEMENT* e = &elements[index];
+	LG_ELEMENT* other;
+	
+	if (display_scroll == NULL || !e->visible)
+		return 0;
+	
+	for (i = 0; i < LG_MAX_ELEMENTS; i++)
+	{
+		other = &elements[i];
+		if (i != index && other->in_use && other->visible &&
+			other->x < e->x + e->width && other->x + other->width > e->x &&
+			other->y < e->y + e->height && other->y + other->height > e->y)
+		{
+			return 0;
+		}
+	}
+	return display_scroll(e->x, e->y, e->width, e->height, dx, dy);
+}
+
+/*
+// updates the bounding box of an element without 
+// repainting it
+*/
+void lg_element_update_bounds(uint16_t index, uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+	elements[index].x = x;
+	elements[index].y = y;
+	elements[index].width = width;
+	elements[index].height = height;
+}
+
+/*
+// updates the bounding box of an element
+*/
+void lg_element_set_bounds(uint16_t index, uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+	LG_ELEMENT* e = &elements[index];
+	
+	if (e->visible)
+		lg_invalidate_move(e->layer, e->x, e->y, e->width, e->height, x, y, width, height);
+
+	e->x = x;
+	e->y = y;
+	e->width = width;
+	e->height = height;
+}
+
+/*
+// removes an element from the display
+*/
+void lg_element_remove(uint16_t index)
+{
+	LG_ELEMENT* e = &elements[index];
+	
+	if (!e->in_use)
+		return;
+	
+	lg_order_remove(index);
+	if (e->visible)
+		lg_invalidate(e->layer, e->x, e->y, e->width, e->height);
+	if (e->ops->release != NULL)
+		e->ops->release(e->data);
+	e->in_use = 0;
+}
+
+/*
+// changes the element visibility
+*/
+void lg_element_set_visibility(uint16_t index, char visible)
+{
+	if (elements[index].visible != visible)
+	{
+		elements[index].visible = visible;
+		/*
+		// repaint
+		*/
+		lg_invalidate(elements[index].layer, elements[index].x, elements[index].y, 
+			elements[index].width, elements[index].height);
+	}
+}
+
+/*
+// moves an element to a different layer
+*/
+void lg_element_set_layer(uint16_t index, unsigned char layer)
+{
+	unsigned char old_layer = elements[index].layer;
+	
+	if (old_layer != layer && layer < LG_LAYER_COUNT)
+	{
+		lg_order_remove(index);
+		elements[index].layer = layer;
+		lg_order_insert(index);
+		if (elements[index].visible)
+		{
+			lg_invalidate(MIN(old_layer, layer), elements[index].x, elements[index].y, 
+				elements[index].width, elements[index].height);
+		}
+	}
+}
+
+/*
+// sets the z-order of an element within it's layer
+*/
+void lg_element_set_z(uint16_t index, signed char z)
+{
+	if (elements[index].z != z)
+	{
+		lg_order_remove(index);
+		elements[index].z = z;
+		lg_order_insert(index);
+		lg_element_invalidate(index);
+	}
+}
+
+/*
+// sets up the layer cache
+*/
+char lg_layer_set_cache(unsigned char layer, LG_RGB* buffer, 
+	uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+	if (buffer != NULL && height > LG_MAX_CACHE_ROWS)
+		return 0;
+	
+	cache.buffer = buffer;
+	cache.layer = layer;
+	cache.x = x;
+	cache.y = y;
+	cache.width = width;
+	cache.height = height;
+	memset(cache.valid, 0, sizeof(cache.valid));
+	return 1;
+}
+
 /*
 // sets the screen background color
 */
 void lg_set_background(LG_RGB color)
 {
 	background = color;	
+	memset(cache.valid, 0, sizeof(cache.valid));
 	paint();
 }
 
@@ -74,6 +592,7 @@ int16_t lg_label_add(unsigned char* str, unsigned char* font,
 	unsigned char font_size, unsigned char spacing, LG_RGB color, uint16_t x, uint16_t y)
 {
 	int16_t i;
+	int16_t index;
 	for (i = 0; i < LG_MAX_STRINGS; i++)
 	{
 		if (!labels[i].in_use)
@@ -85,31 +604,37 @@ int16_t lg_label_add(unsigned char* str, unsigned char* font,
 			labels[i].size = font_size;
 			labels[i].spacing = spacing;
 			labels[i].color = color;
-			labels[i].visible = 1;
-			labels[i].in_use = 1;
 			
-			paint_partial(labels[i].x, labels[i].y, labels[i].length * ((8 + labels[i].spacing) * labels[i].size), 8 * labels[i].size);
+			index = lg_element_add(&label_ops, &labels[i], LG_LAYER_CONTENT, labels[i].x, labels[i].y, 
+				labels[i].length * ((8 + labels[i].spacing) * labels[i].size), 8 * labels[i].size);
+			if (index >= 0)
+				labels[i].in_use = 1;
 			
-			return i;
+			return index;
 		}
 	}
 	return - 1;
 }
 
+/*
+// releases a label slot
+*/
+static void lg_label_release(void* data)
+{
+	((LG_LABEL*) data)->in_use = 0;
+}
+
 /*
 // changes the label string
 */
 void lg_label_set_string(uint16_t index, unsigned char* string)
 {
-	int newlen = strlen((char*)string);
-	labels[index].string = string;
+	LG_LABEL* label = (LG_LABEL*) elements[index].data;
+	label->string = string;
+	label->length = strlen((char*)string);
 	
-	if (newlen > labels[index].length)
-		labels[index].length = newlen;
-	
-	paint_partial(labels[index].x, labels[index].y, 
-		labels[index].length * ((8 + labels[index].spacing) * labels[index].size), 8 * labels[index].size);
-	labels[index].length = newlen;
+	lg_element_set_bounds(index, label->x, label->y, 
+		label->length * ((8 + label->spacing) * label->size), 8 * label->size);
 }
 
 /*
@@ -117,15 +642,7 @@ void lg_label_set_string(uint16_t index, unsigned char* string)
 */
 void lg_label_set_visibility(uint16_t index, char visible)
 {
-	if (labels[index].visible != visible)
-	{
-		labels[index].visible = visible;
-		/*
-		// repaint
-		*/
-		paint_partial(labels[index].x, labels[index].y, 
-			labels[index].length * ((8 + labels[index].spacing) * labels[index].size), 8 * labels[index].size);
-	}
+	lg_element_set_visibility(index, visible);
 }
 
 /*
@@ -133,92 +650,154 @@ void lg_label_set_visibility(uint16_t index, char visible)
 */
 void lg_label_set_color(uint16_t index, LG_RGB color)
 {
-	if (labels[index].color != color)
+	LG_LABEL* label = (LG_LABEL*) elements[index].data;
+	if (label->color != color)
 	{
 		/*
 		// update label color
 		*/ 
-		labels[index].color = color;
+		label->color = color;
 		/*
 		// repaint
 		*/
-		paint_partial(labels[index].x, labels[index].y, 
-			labels[index].length * ((8 + labels[index].spacing) * labels[index].size), 8 * labels[index].size);
+		lg_element_invalidate(index);
 	}
 }
 
 /*
-// gets the value of a pixel, driver must call this function
+// composites the elements in the draw list range [first, last)
+// over a span of pixels
 */
-LG_RGB lg_get_pixel(uint16_t x, uint16_t y)
+static void lg_compose(uint16_t x, uint16_t y, uint16_t width, LG_RGB* span, 
+	unsigned char first, unsigned char last)
 {
-	static int i;
-	LG_RGB pixel;
+	unsigned char i;
+	uint16_t x_start;
+	uint16_t x_end;
+	LG_ELEMENT* e;
 	
-	pixel = background;
-	
-	for (i = 0; i < LG_MAX_STRINGS; i++)
+	for (i = first; i < last; i++)
 	{
-		if (labels[i].visible)
-		{
-			pixel = lg_get_string_pixel(labels[i], x, y, pixel);
+		e = &elements[draw_order[i]];
+		/*
+		// skip elements that are hidden or don't intersect
+		// the span
+		*/
+		if (!e->visible || y < e->y || y >= e->y + e->height)
+			continue;
+		x_start = MAX(x, e->x);
+		x_end = MIN(x + width, e->x + e->width);
+		if (x_start >= x_end)
+			continue;
 		
-		}
+		e->ops->render(e->data, x_start, y, x_end - x_start, &span[x_start - x]);
 	}
-	
-	return pixel;
 }
 
 /*
-// gets the value of a label pixel
+// renders a span of pixels
 */
-LG_RGB lg_get_string_pixel(LG_LABEL str, uint16_t x, uint16_t y, LG_RGB background)
+void lg_render_span(uint16_t x, uint16_t y, uint16_t width, LG_RGB* span)
 {
-	static uint16_t str_pos;
-	static uint16_t char_x;
-	static uint16_t char_y;
-	/*
-	// if the label is invisible return the background color
-	*/
-	if (!str.visible)
-		return background;
-	/*
-	// if the pixel is not within this label return background color
-	*/
-	if (x < str.x) return background;
-	if (y < str.y) 
+	uint16_t i;
+	uint16_t row;
+	uint16_t cached_start;
+	uint16_t cached_end;
+	unsigned char first = 0;
+	LG_RGB* cached;
+	
+	if (cache.buffer != NULL && y >= cache.y && y < cache.y + cache.height &&
+		x < cache.x + cache.width && x + width > cache.x)
 	{
-		return background;
-	}	
-	else if (y >= (str.y + (8 * str.size)))
+		cached_start = MAX(x, cache.x);
+		cached_end = MIN(x + width, cache.x + cache.width);
+		/*
+		// render the part of the span that falls left of the
+		// cached area, the spans are rendered left to right so
+		// elements that decode sequentially don't have to rewind
+		*/
+		if (cached_start > x)
+			lg_render_span(x, y, cached_start - x, span);
+		/*
+		// find the first element above the cached layer
+		*/
+		while (first < draw_count && elements[draw_order[first]].layer <= cache.layer)
+			first++;
+		/*
+		// if the cached row is not valid render the cached
+		// layers for the whole row
+		*/
+		row = y - cache.y;
+		cached = &cache.buffer[(uint32_t) row * cache.width];
+		if (!(cache.valid[row >> 3] & (1 << (row & 7))))
+		{
+			for (i = 0; i < cache.width; i++)
+				cached[i] = background;
+			lg_compose(cache.x, y, cache.width, cached, 0, first);
+			cache.valid[row >> 3] |= (1 << (row & 7));
+		}
+		/*
+		// composite the layers above the cache on top
+		// of the cached pixels
+		*/
+		memcpy(&span[cached_start - x], &cached[cached_start - cache.x], (cached_end - cached_start) * sizeof(LG_RGB));
+		lg_compose(cached_start, y, cached_end - cached_start, &span[cached_start - x], first, draw_count);
+		/*
+		// render the part of the span right of the cached area
+		*/
+		if (cached_end < x + width)
+			lg_render_span(cached_end, y, (x + width) - cached_end, &span[cached_end - x]);
+	}
+	else
 	{
-		return background;
+		for (i = 0; i < width; i++)
+			span[i] = background;
+		lg_compose(x, y, width, span, 0, draw_count);
 	}
+}
+
+/*
+// gets the value of a pixel, driver must call this function
+// or lg_render_span
+*/
+LG_RGB lg_get_pixel(uint16_t x, uint16_t y)
+{
+	LG_RGB pixel;
+	lg_render_span(x, y, 1, &pixel);
+	return pixel;
+}
+
+/*
+// renders a span of a label
+*/
+static void lg_label_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span)
+{
+	uint16_t i;
+	uint16_t str_pos;
+	uint16_t char_x;
+	uint16_t char_width;
+	unsigned char font_row;
+	LG_LABEL* str = (LG_LABEL*) data;
 	/*
-	// find the position of the current char on the string
-	*/
-	str_pos = (x - str.x) / ((8 + str.spacing) * str.size);
-	/*
-	// if we've reached the end of the string return the
-	// background color
-	*/
-	if (str_pos >= str.length)
-		return background;
-	/*
-	// calculate position of the pixel within the font
+	// find the position of the first char on the span and 
+	// the font row for this scanline
 	*/
-	char_x = ((x - str.x) - (str_pos * ((8 + str.spacing) * str.size))) / str.size;
-	char_y = (y - str.y) / str.size; 
-	/*
-	// return the pixel value
-	*/	
-	if ((font[str.string[str_pos]][char_y] << char_x) & 0x80)
+	char_width = (8 + str->spacing) * str->size;
+	str_pos = (x - str->x) / char_width;
+	char_x = (x - str->x) - (str_pos * char_width);
+	font_row = (y - str->y) / str->size;
+	
+	for (i = 0; i < width && str_pos < str->length; i++)
 	{
-		return str.color;
+		if ((char_x / str->size) < 8 && 
+			LG_GLYPH_PIXEL(str->string[str_pos], font_row, char_x / str->size))
+		{
+			span[i] = str->color;
+		}
+		if (++char_x == char_width)
+		{
+			char_x = 0;
+			str_pos++;
+		}
 	}
-	else
-	{	
-		return background;
-	}	
 }
-
@@ -40,6 +40,134 @@ LG_RGB;
 
 typedef void (*LG_DISPLAY_PAINT)(void);
 typedef void (*LG_DISPLAY_PAINT_PARTIAL)(uint16_t x, uint16_t y, uint16_t width, uint16_t height);
+typedef char (*LG_DISPLAY_BUSY)(void);
+typedef char (*LG_DISPLAY_SCROLL)(uint16_t x, uint16_t y, uint16_t width, uint16_t height, int16_t dx, int16_t dy);
+
+typedef struct LG_POINT
+{
+	int16_t x;
+	int16_t y;
+}
+LG_POINT;
+
+/*
+// bitmap formats. Rows of 1 and 4 bpp bitmaps start on a byte boundary
+// and the leftmost pixel is on the most significant bits. RGB565 pixels
+// are stored as 2 bytes, low byte first. RLE bitmaps are a stream of 
+// RGB565 packets that may cross rows, each packet starts with a byte
+// whose low 7 bits are the pixel count minus one and if the high bit is
+// set it is followed by a single pixel that is repeated, otherwise by
+// count pixels.
+*/
+#define LG_BITMAP_1BPP			0
+#define LG_BITMAP_4BPP			1
+#define LG_BITMAP_RGB565		2
+#define LG_BITMAP_RLE			3
+
+typedef struct LG_BITMAP
+{
+	unsigned char format;
+	uint16_t width;
+	uint16_t height;
+	const LG_RGB* palette;
+	const unsigned char* data;
+}
+LG_BITMAP;
+
+/*
+// byte stream used by compressed assets, it reads either from memory
+// or through a callback that returns the number of bytes read at the
+// given offset
+*/
+#define LG_STREAM_BUFFER_SIZE	32
+
+typedef uint16_t (*LG_STREAM_READ)(void* context, uint32_t offset, unsigned char* buffer, uint16_t length);
+
+typedef struct LG_STREAM
+{
+	const unsigned char* data;
+	uint32_t size;
+	LG_STREAM_READ read;
+	void* context;
+	uint32_t offset;
+	uint32_t buffer_offset;
+	uint16_t buffer_length;
+	unsigned char buffer[LG_STREAM_BUFFER_SIZE];
+}
+LG_STREAM;
+
+/*
+// QOI image decoder. The decoder state is about 300 bytes and is
+// provided by the application so it's only allocated while needed
+*/
+typedef struct LG_QOI
+{
+	LG_STREAM stream;
+	uint16_t width;
+	uint16_t height;
+	uint32_t position;
+	unsigned char run;
+	unsigned char px[4];
+	unsigned char index[64][4];
+}
+LG_QOI;
+
+/*
+// chart modes. Sweep charts draw each sample over the oldest one 
+// leaving a blank column after the newest sample, scroll charts move
+// the samples left as new ones are added
+*/
+#define LG_CHART_SWEEP			0
+#define LG_CHART_SCROLL			1
+
+/*
+// log modes. Wrap logs write each new line over the oldest one,
+// scroll logs move all lines up and add the new one at the bottom.
+// Appending to a wrap log only repaints the characters that change
+// on one line. A scroll log can only be scrolled by the display if
+// it covers the whole height of the screen, otherwise every line
+// repaints the characters that differ from the line bellow it which
+// for typical text is close to repainting the whole log
+*/
+#define LG_LOG_WRAP				0
+#define LG_LOG_SCROLL			1
+
+/*
+// text box alignments
+*/
+#define LG_ALIGN_LEFT			0
+#define LG_ALIGN_CENTER			1
+#define LG_ALIGN_RIGHT			2
+
+/*
+// bar flags. Horizontal bars fill from left to right and vertical
+// bars from bottom to top, percent bars show the value as text
+*/
+#define LG_BAR_HORIZONTAL		0
+#define LG_BAR_VERTICAL			1
+#define LG_BAR_PERCENT			2
+
+/*
+// tween easing functions
+*/
+#define LG_EASE_LINEAR			0
+#define LG_EASE_IN				1
+#define LG_EASE_OUT				2
+#define LG_EASE_IN_OUT			3
+
+typedef void (*LG_TWEEN_SET_VALUE)(uint16_t index, int16_t value);
+typedef void (*LG_TWEEN_SET_POSITION)(uint16_t index, uint16_t x, uint16_t y);
+typedef void (*LG_TWEEN_SET_COLOR)(uint16_t index, LG_RGB color);
+
+/*
+// display layers. Elements are drawn in layer order and within
+// a layer by ascending z-order, elements with the same layer and
+// z-order are drawn in the order in which they were added
+*/
+#define LG_LAYER_BACKGROUND		0
+#define LG_LAYER_CONTENT		1
+#define LG_LAYER_OVERLAY		2
+#define LG_LAYER_COUNT			3
 
 
 /**
@@ -51,6 +179,49 @@ void lg_init
 	LG_DISPLAY_PAINT_PARTIAL display_paint_partial
 );
 
+/**
+ * <summary>Sets the function used to check if the display is still
+ * painting (ie. ili9341_is_painting).</summary>
+ */
+void lg_set_busy_callback
+(
+	LG_DISPLAY_BUSY busy
+);
+
+/**
+ * <summary>
+ * Sets the function used to scroll a region of the display by dx pixels
+ * horizontally and dy pixels vertically. The function returns 0 if the
+ * display cannot scroll that region in that direction, otherwise the 
+ * display must keep showing the scrolled contents
+ * until the region is repainted.
+ * </summary>
+ */
+void lg_set_scroll_callback
+(
+	LG_DISPLAY_SCROLL scroll
+);
+
+/**
+ * <summary>Checks if the display is still painting. Returns 0 if there
+ * is no busy callback.</summary>
+ */
+char lg_display_is_busy(void);
+
+/**
+ * <summary>
+ * Starts a batch of changes. The areas damaged until lg_end_update is
+ * called are merged and repainted when the batch ends. Batches may
+ * be nested.
+ * </summary>
+ */
+void lg_begin_update(void);
+
+/**
+ * <summary>Ends a batch of changes.</summary>
+ */
+void lg_end_update(void);
+
 /**
  * <summary>Sets the background color of the display.</summary>
  */
@@ -105,4 +276,842 @@ void lg_label_set_visibility
  */
 void lg_label_set_color(uint16_t index, LG_RGB color);
 
+/**
+ * <summary>Adds a filled rectangle to the display.</summary>
+ */
+int16_t lg_rect_add
+(
+	uint16_t x, 
+	uint16_t y, 
+	uint16_t width, 
+	uint16_t height, 
+	LG_RGB color
+);
+
+/**
+ * <summary>Adds a horizontal line to the display.</summary>
+ */
+int16_t lg_hline_add
+(
+	uint16_t x, 
+	uint16_t y, 
+	uint16_t length, 
+	LG_RGB color
+);
+
+/**
+ * <summary>Adds a vertical line to the display.</summary>
+ */
+int16_t lg_vline_add
+(
+	uint16_t x, 
+	uint16_t y, 
+	uint16_t length, 
+	LG_RGB color
+);
+
+/**
+ * <summary>Adds a rectangular frame to the display.</summary>
+ */
+int16_t lg_frame_add
+(
+	uint16_t x, 
+	uint16_t y, 
+	uint16_t width, 
+	uint16_t height, 
+	unsigned char thickness, 
+	LG_RGB color
+);
+
+/**
+ * <summary>Adds a line to the display.</summary>
+ */
+int16_t lg_line_add
+(
+	uint16_t x1, 
+	uint16_t y1, 
+	uint16_t x2, 
+	uint16_t y2, 
+	LG_RGB color
+);
+
+/**
+ * <summary>Adds a rounded rectangle to the display.</summary>
+ */
+int16_t lg_rounded_rect_add
+(
+	uint16_t x, 
+	uint16_t y, 
+	uint16_t width, 
+	uint16_t height, 
+	unsigned char radius, 
+	char antialias, 
+	LG_RGB color
+);
+
+/**
+ * <summary>
+ * Adds a button to the display. The button is a rounded rectangle
+ * with a centered label on top of it, use lg_button_get_label to 
+ * change the label.
+ * </summary>
+ */
+int16_t lg_button_add
+(
+	uint16_t x, 
+	uint16_t y, 
+	uint16_t width, 
+	uint16_t height, 
+	unsigned char radius, 
+	LG_RGB color, 
+	unsigned char* text, 
+	unsigned char font_size, 
+	LG_RGB text_color
+);
+
+/**
+ * <summary>Gets the index of the label of a button.</summary>
+ */
+int16_t lg_button_get_label
+(
+	uint16_t index
+);
+
+/**
+ * <summary>Changes the end points of a line.</summary>
+ */
+void lg_line_set_points
+(
+	uint16_t index, 
+	uint16_t x1, 
+	uint16_t y1, 
+	uint16_t x2, 
+	uint16_t y2
+);
+
+/**
+ * <summary>Changes the bounds of a rectangle, rounded rectangle or frame.</summary>
+ */
+void lg_shape_set_bounds
+(
+	uint16_t index, 
+	uint16_t x, 
+	uint16_t y, 
+	uint16_t width, 
+	uint16_t height
+);
+
+/**
+ * <summary>Sets the color of a rectangle, rounded rectangle, frame or line.</summary>
+ */
+void lg_shape_set_color
+(
+	uint16_t index, 
+	LG_RGB color
+);
+
+/**
+ * <summary>Adds an anti-aliased line to the display.</summary>
+ */
+int16_t lg_aaline_add
+(
+	uint16_t x1, 
+	uint16_t y1, 
+	uint16_t x2, 
+	uint16_t y2, 
+	LG_RGB color
+);
+
+/**
+ * <summary>
+ * Adds an anti-aliased gauge needle to the display. Angles are in
+ * degrees clockwise from the positive x axis.
+ * </summary>
+ */
+int16_t lg_needle_add
+(
+	uint16_t cx, 
+	uint16_t cy, 
+	uint16_t length, 
+	int16_t angle, 
+	LG_RGB color
+);
+
+/**
+ * <summary>Sets the angle of a gauge needle.</summary>
+ */
+void lg_needle_set_angle
+(
+	uint16_t index, 
+	int16_t angle
+);
+
+/**
+ * <summary>Adds an anti-aliased circle to the display. A thickness
+ * of 0 draws a filled circle.</summary>
+ */
+int16_t lg_circle_add
+(
+	uint16_t cx, 
+	uint16_t cy, 
+	uint16_t radius, 
+	unsigned char thickness, 
+	LG_RGB color
+);
+
+/**
+ * <summary>Adds an anti-aliased arc that goes clockwise from start_angle
+ * to end_angle.</summary>
+ */
+int16_t lg_arc_add
+(
+	uint16_t cx, 
+	uint16_t cy, 
+	uint16_t radius, 
+	unsigned char thickness, 
+	int16_t start_angle, 
+	int16_t end_angle, 
+	LG_RGB color
+);
+
+/**
+ * <summary>Sets the color of an anti-aliased line, needle, circle or arc.</summary>
+ */
+void lg_aa_set_color
+(
+	uint16_t index, 
+	LG_RGB color
+);
+
+/**
+ * <summary>Gets the sine of an angle in degrees (1.0 = 16384).</summary>
+ */
+int16_t lg_sin
+(
+	int16_t angle
+);
+
+/**
+ * <summary>Gets the cosine of an angle in degrees (1.0 = 16384).</summary>
+ */
+int16_t lg_cos
+(
+	int16_t angle
+);
+
+/**
+ * <summary>
+ * Adds a filled polygon to the display. The points are relative to
+ * (x, y) and are not copied so they must remain valid while the polygon
+ * is in use.
+ * </summary>
+ */
+int16_t lg_polygon_add
+(
+	const LG_POINT* points, 
+	unsigned char count, 
+	uint16_t x, 
+	uint16_t y, 
+	LG_RGB color
+);
+
+/**
+ * <summary>Moves a polygon.</summary>
+ */
+void lg_polygon_set_position
+(
+	uint16_t index, 
+	uint16_t x, 
+	uint16_t y
+);
+
+/**
+ * <summary>Sets the color of a polygon.</summary>
+ */
+void lg_polygon_set_color
+(
+	uint16_t index, 
+	LG_RGB color
+);
+
+/**
+ * <summary>
+ * Adds an image to the display. The bitmap is not copied so it must
+ * remain valid while the image is in use. If transparent is set pixels
+ * with palette index 0 are not drawn.
+ * </summary>
+ */
+int16_t lg_image_add
+(
+	const LG_BITMAP* bitmap, 
+	uint16_t x, 
+	uint16_t y, 
+	char transparent
+);
+
+/**
+ * <summary>Moves an image.</summary>
+ */
+void lg_image_set_position
+(
+	uint16_t index, 
+	uint16_t x, 
+	uint16_t y
+);
+
+/**
+ * <summary>Changes the bitmap of an image.</summary>
+ */
+void lg_image_set_bitmap
+(
+	uint16_t index, 
+	const LG_BITMAP* bitmap
+);
+
+/**
+ * <summary>
+ * Adds a sprite. Sprites are drawn by a single element on the overlay
+ * layer, when they overlap the one with the highest index is on top.
+ * The bitmap is not copied so it must remain valid while the sprite is
+ * in use. Returns the index of the sprite or -1 if there are no free 
+ * sprites.
+ * </summary>
+ */
+int16_t lg_sprite_add
+(
+	const LG_BITMAP* bitmap, 
+	uint16_t x, 
+	uint16_t y, 
+	char transparent
+);
+
+/**
+ * <summary>Removes a sprite.</summary>
+ */
+void lg_sprite_remove
+(
+	uint16_t index
+);
+
+/**
+ * <summary>Moves a sprite. Only the old and new areas of the sprite are
+ * repainted, or their union if they overlap.</summary>
+ */
+void lg_sprite_move
+(
+	uint16_t index, 
+	uint16_t x, 
+	uint16_t y
+);
+
+/**
+ * <summary>Changes the bitmap of a sprite.</summary>
+ */
+void lg_sprite_set_bitmap
+(
+	uint16_t index, 
+	const LG_BITMAP* bitmap
+);
+
+/**
+ * <summary>Sets the visibility of a sprite.</summary>
+ */
+void lg_sprite_set_visibility
+(
+	uint16_t index, 
+	char visible
+);
+
+/**
+ * <summary>
+ * Adds a chart to the display. The chart draws a sample on each column 
+ * so the samples buffer must hold width bytes and it's height can be up
+ * to 256 pixels. Samples are clipped to the [min, max] range. In scroll
+ * mode the chart uses the display's hardware scrolling when no other
+ * element overlaps it.
+ * </summary>
+ */
+int16_t lg_chart_add
+(
+	unsigned char* samples, 
+	uint16_t x, 
+	uint16_t y, 
+	uint16_t width, 
+	uint16_t height, 
+	int16_t min, 
+	int16_t max, 
+	unsigned char mode, 
+	LG_RGB color, 
+	LG_RGB background
+);
+
+/**
+ * <summary>Adds a sample to a chart. Only the columns that change are
+ * repainted.</summary>
+ */
+void lg_chart_add_sample
+(
+	uint16_t index, 
+	int16_t value
+);
+
+/**
+ * <summary>Removes all the samples of a chart.</summary>
+ */
+void lg_chart_clear
+(
+	uint16_t index
+);
+
+/**
+ * <summary>
+ * Adds a text log to the display. The lines buffer must hold line_count
+ * * line_length bytes, lines can be up to 64 characters long. Appending
+ * a line only repaints the characters that change, in scroll mode the
+ * log uses the display's hardware scrolling when it can.
+ * </summary>
+ */
+int16_t lg_log_add
+(
+	unsigned char* lines, 
+	unsigned char line_count, 
+	unsigned char line_length, 
+	uint16_t x, 
+	uint16_t y, 
+	unsigned char font_size, 
+	unsigned char mode, 
+	LG_RGB color, 
+	LG_RGB background
+);
+
+/**
+ * <summary>Appends a line to a log.</summary>
+ */
+void lg_log_append
+(
+	uint16_t index, 
+	const char* text
+);
+
+/**
+ * <summary>Removes all lines from a log.</summary>
+ */
+void lg_log_clear
+(
+	uint16_t index
+);
+
+/**
+ * <summary>
+ * Adds a marquee that scrolls a line of text from right to left by step
+ * pixels every period milliseconds. The masks buffer must hold 8 bytes
+ * for each of max_length characters, longer texts are cut. The text
+ * is copied into the masks so it doesn't need to remain valid.
+ * </summary>
+ */
+int16_t lg_marquee_add
+(
+	const char* text, 
+	unsigned char* masks, 
+	uint16_t max_length, 
+	uint16_t x, 
+	uint16_t y, 
+	uint16_t width, 
+	unsigned char font_size, 
+	unsigned char step, 
+	uint16_t period, 
+	LG_RGB color, 
+	LG_RGB background
+);
+
+/**
+ * <summary>Changes the text of a marquee.</summary>
+ */
+void lg_marquee_set_text
+(
+	uint16_t index, 
+	const char* text
+);
+
+/**
+ * <summary>
+ * Advances the marquees, must be called from the application loop with
+ * a millisecond tick count. Only the marquee band is repainted and the
+ * marquees don't move while the display is busy painting. Returns
+ * non-zero if there are any marquees.
+ * </summary>
+ */
+char lg_marquee_process
+(
+	uint32_t now
+);
+
+/**
+ * <summary>
+ * Adds a text box that wraps the text at spaces to fit the given width.
+ * Each line is aligned with LG_ALIGN_LEFT, LG_ALIGN_CENTER or LG_ALIGN_RIGHT
+ * and lines are line_spacing pixels apart. The height of the text box 
+ * depends on the number of lines. The text is not copied so it must remain 
+ * valid while it's shown.
+ * </summary>
+ */
+int16_t lg_textbox_add
+(
+	const char* text, 
+	uint16_t x, 
+	uint16_t y, 
+	uint16_t width, 
+	unsigned char font_size, 
+	unsigned char spacing, 
+	unsigned char line_spacing, 
+	unsigned char align, 
+	LG_RGB color
+);
+
+/**
+ * <summary>Changes the text of a text box.</summary>
+ */
+void lg_textbox_set_text
+(
+	uint16_t index, 
+	const char* text
+);
+
+/**
+ * <summary>Changes the alignment of a text box.</summary>
+ */
+void lg_textbox_set_align
+(
+	uint16_t index, 
+	unsigned char align
+);
+
+/**
+ * <summary>Sets the color of a text box.</summary>
+ */
+void lg_textbox_set_color
+(
+	uint16_t index, 
+	LG_RGB color
+);
+
+/**
+ * <summary>
+ * Adds a progress bar or level meter. The flags are LG_BAR_HORIZONTAL
+ * or LG_BAR_VERTICAL optionally combined with LG_BAR_PERCENT. The bar
+ * starts at the min value.
+ * </summary>
+ */
+int16_t lg_bar_add
+(
+	uint16_t x, 
+	uint16_t y, 
+	uint16_t width, 
+	uint16_t height, 
+	int16_t min, 
+	int16_t max, 
+	unsigned char flags, 
+	LG_RGB color, 
+	LG_RGB background
+);
+
+/**
+ * <summary>
+ * Sets the value of a bar. Only the strip between the old and new fill
+ * positions (and the percentage if shown) is repainted.
+ * </summary>
+ */
+void lg_bar_set_value
+(
+	uint16_t index, 
+	int16_t value
+);
+
+/**
+ * <summary>Gets the value of a bar.</summary>
+ */
+int16_t lg_bar_get_value
+(
+	uint16_t index
+);
+
+/**
+ * <summary>
+ * Sets the value above which the fill of a bar is drawn with a different
+ * color, ie. the red zone of a level meter.
+ * </summary>
+ */
+void lg_bar_set_level
+(
+	uint16_t index, 
+	int16_t value, 
+	LG_RGB color
+);
+
+/**
+ * <summary>Opens a QOI image stored in memory. Returns 0 if the image
+ * is not valid.</summary>
+ */
+char lg_qoi_open_memory
+(
+	LG_QOI* qoi, 
+	const unsigned char* data, 
+	uint32_t size
+);
+
+/**
+ * <summary>Opens a QOI image that is read through a callback. The callback
+ * returns the number of bytes read at the given offset. Returns 0 if the
+ * image is not valid.</summary>
+ */
+char lg_qoi_open
+(
+	LG_QOI* qoi, 
+	LG_STREAM_READ read, 
+	void* context
+);
+
+/**
+ * <summary>Rewinds a QOI decoder to the first pixel.</summary>
+ */
+void lg_qoi_rewind
+(
+	LG_QOI* qoi
+);
+
+/**
+ * <summary>Decodes a span of pixels of a QOI image. Reading spans in
+ * order is cheap, going back rewinds the stream.</summary>
+ */
+void lg_qoi_read_span
+(
+	LG_QOI* qoi, 
+	uint16_t x, 
+	uint16_t y, 
+	uint16_t width, 
+	LG_RGB* span
+);
+
+/**
+ * <summary>Adds a QOI image to the display. The decoder must remain
+ * valid while the image is in use.</summary>
+ */
+int16_t lg_qoi_add
+(
+	LG_QOI* qoi, 
+	uint16_t x, 
+	uint16_t y
+);
+
+/**
+ * <summary>
+ * Adds an animation stored in memory to the display. The frame buffer
+ * holds the current frame in RGB565 and must be width * height pixels.
+ * The animation starts with a header made of the bytes 'L', 'G', 'A', 1
+ * followed by the width, height, number of frames and frame period in
+ * milliseconds as 16 bit little endian values. Each frame is a byte
+ * with the number of rectangles that changed followed by each rectangle's
+ * x, y, width and height (16 bit little endian) and it's pixels in the
+ * LG_BITMAP_RLE format. The first frame must cover the whole animation.
+ * </summary>
+ */
+int16_t lg_animation_add_memory
+(
+	const unsigned char* data, 
+	uint32_t size, 
+	uint16_t* framebuffer, 
+	uint16_t x, 
+	uint16_t y
+);
+
+/**
+ * <summary>Adds an animation that is read through a callback to the display.</summary>
+ */
+int16_t lg_animation_add
+(
+	LG_STREAM_READ read, 
+	void* context, 
+	uint16_t* framebuffer, 
+	uint16_t x, 
+	uint16_t y
+);
+
+/**
+ * <summary>Starts playing an animation from the first frame.</summary>
+ */
+void lg_animation_play
+(
+	uint16_t index, 
+	char loop
+);
+
+/**
+ * <summary>Stops an animation on the current frame.</summary>
+ */
+void lg_animation_stop
+(
+	uint16_t index
+);
+
+/**
+ * <summary>Checks if an animation is playing.</summary>
+ */
+char lg_animation_is_playing
+(
+	uint16_t index
+);
+
+/**
+ * <summary>
+ * Advances all playing animations, must be called from the application
+ * loop with a millisecond tick count. Each call decodes a bounded number 
+ * of pixels. Returns non-zero while a frame is being decoded.
+ * </summary>
+ */
+char lg_animation_process
+(
+	uint32_t now
+);
+
+/**
+ * <summary>
+ * Animates a value of an element (ie. lg_needle_set_angle) from one value
+ * to another over duration milliseconds. The value is set to the starting 
+ * value right away. Returns the index of the tween or -1 if there are no 
+ * free tweens.
+ * </summary>
+ */
+int16_t lg_tween_value
+(
+	uint16_t index, 
+	LG_TWEEN_SET_VALUE set, 
+	int16_t from, 
+	int16_t to, 
+	uint16_t duration, 
+	unsigned char easing
+);
+
+/**
+ * <summary>Animates the position of an element (ie. lg_sprite_move).</summary>
+ */
+int16_t lg_tween_position
+(
+	uint16_t index, 
+	LG_TWEEN_SET_POSITION set, 
+	uint16_t x1, 
+	uint16_t y1, 
+	uint16_t x2, 
+	uint16_t y2, 
+	uint16_t duration, 
+	unsigned char easing
+);
+
+/**
+ * <summary>Animates the color of an element (ie. lg_label_set_color).</summary>
+ */
+int16_t lg_tween_color
+(
+	uint16_t index, 
+	LG_TWEEN_SET_COLOR set, 
+	LG_RGB from, 
+	LG_RGB to, 
+	uint16_t duration, 
+	unsigned char easing
+);
+
+/**
+ * <summary>Stops a tween on it's current value.</summary>
+ */
+void lg_tween_stop
+(
+	uint16_t tween
+);
+
+/**
+ * <summary>Checks if a tween is running.</summary>
+ */
+char lg_tween_is_running
+(
+	uint16_t tween
+);
+
+/**
+ * <summary>
+ * Advances all running tweens, must be called from the application loop
+ * with a millisecond tick count. The changes made on each call are
+ * repainted as a single batch. While the display is busy painting no
+ * changes are made so the frames that can't be painted in time are 
+ * skipped. Returns non-zero while any tween is running.
+ * </summary>
+ */
+char lg_tween_process
+(
+	uint32_t now
+);
+
+/**
+ * <summary>Removes an element from the display.</summary>
+ */
+void lg_element_remove
+(
+	uint16_t index
+);
+
+/**
+ * <summary>Sets the visibility of an element.</summary>
+ */
+void lg_element_set_visibility
+(
+	uint16_t index, 
+	char visible
+);
+
+/**
+ * <summary>Moves an element to a different layer.</summary>
+ */
+void lg_element_set_layer
+(
+	uint16_t index, 
+	unsigned char layer
+);
+
+/**
+ * <summary>Sets the z-order of an element within it's layer.</summary>
+ */
+void lg_element_set_z
+(
+	uint16_t index, 
+	signed char z
+);
+
+/**
+ * <summary>
+ * Caches the composited output of a layer (and all layers bellow it)
+ * over the specified area. The buffer must hold width * height pixels.
+ * Pass a NULL buffer to disable the cache. Returns 0 if the area is too
+ * large.
+ * </summary>
+ */
+char lg_layer_set_cache
+(
+	unsigned char layer, 
+	LG_RGB* buffer, 
+	uint16_t x, 
+	uint16_t y, 
+	uint16_t width, 
+	uint16_t height
+);
+
+/**
+ * <summary>Renders a horizontal span of pixels, driver must call this function
+ * or lg_get_pixel.</summary>
+ */
+void lg_render_span
+(
+	uint16_t x, 
+	uint16_t y, 
+	uint16_t width, 
+	LG_RGB* span
+);
+
 #endif
@@ -0,0 +1,250 @@
+/*
+ * lglib - Lightweight Graphics Library for Embedded Systems
+ * Copyright (C) 2013 Fernando Rodriguez (support@fernansoft.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "font.h"
+#include <string.h>
+#include "lg.h"
+#include "element.h"
+
+#define LG_MAX_LOGS				2
+#define LG_MAX_LOG_LINE_LENGTH	64
+
+typedef struct LG_LOG
+{
+	char in_use;
+	unsigned char mode;
+	int16_t index;
+	uint16_t x;
+	uint16_t y;
+	unsigned char size;
+	unsigned char line_count;
+	unsigned char line_length;
+	unsigned char first;
+	unsigned char count;
+	LG_RGB color;
+	LG_RGB background;
+	unsigned char* lines;
+}
+LG_LOG;
+
+static LG_LOG logs[LG_MAX_LOGS];
+
+/*
+// prototypes
+*/
+static void lg_log_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span);
+static void lg_log_release(void* data);
+
+static const LG_ELEMENT_OPS log_ops = { lg_log_render, lg_log_release };
+
+/*
+// gets a line buffer from it's position on the ring
+*/
+#define LG_LOG_LINE(log, n)		\
+	(&(log)->lines[(uint16_t) (((n) >= (log)->line_count) ? (n) - (log)->line_count : (n)) * (log)->line_length])
+
+/*
+// adds a log to the display
+*/
+int16_t lg_log_add(unsigned char* lines, unsigned char line_count, unsigned char line_length, 
+	uint16_t x, uint16_t y, unsigned char font_size, unsigned char mode, LG_RGB color, LG_RGB background)
+{
+	int16_t i;
+	
+	if (line_length > LG_MAX_LOG_LINE_LENGTH)
+		line_length = LG_MAX_LOG_LINE_LENGTH;
+	
+	for (i = 0; i < LG_MAX_LOGS; i++)
+	{
+		if (!logs[i].in_use)
+		{
+			logs[i].lines = lines;
+			logs[i].line_count = line_count;
+			logs[i].line_length = line_length;
+			logs[i].x = x;
+			logs[i].y = y;
+			logs[i].size = font_size;
+			logs[i].mode = mode;
+			logs[i].color = color;
+			logs[i].background = background;
+			logs[i].first = 0;
+			logs[i].count = 0;
+			memset(lines, 0, (uint16_t) line_count * line_length);
+			logs[i].index = lg_element_add(&log_ops, &logs[i], LG_LAYER_CONTENT, x, y, 
+				(uint16_t) line_length * 8 * font_size, (uint16_t) line_count * 8 * font_size);
+			if (logs[i].index >= 0)
+				logs[i].in_use = 1;
+			return logs[i].index;
+		}
+	}
+	return -1;
+}
+
+/*
+// releases a log
+*/
+static void lg_log_release(void* data)
+{
+	((LG_LOG*) data)->in_use = 0;
+}
+
+/*
+// repaints the characters that differ between the old and
+// new contents of a line on the screen
+*/
+static void lg_log_invalidate_line(LG_LOG* log, unsigned char line, 
+	const unsigned char* old_text, const unsigned char* text)
+{
+	uint16_t start = 0;
+	uint16_t end = log->line_length;
+	uint16_t char_size = 8 * log->size;
+	
+	while (start < end && old_text[start] == text[start])
+		start++;
+	while (end > start && old_text[end - 1] == text[end - 1])
+		end--;
+	
+	if (start < end)
+	{
+		lg_element_invalidate_rect(log->index, log->x + start * char_size, 
+			log->y + line * char_size, (end - start) * char_size, char_size);
+	}
+}
+
+/*
+// appends a line to a log. Text that doesn't fit is cut
+*/
+void lg_log_append(uint16_t index, const char* text)
+{
+	unsigned char i;
+	unsigned char line;
+	unsigned char* slot;
+	unsigned char new_text[LG_MAX_LOG_LINE_LENGTH];
+	LG_LOG* log = (LG_LOG*) lg_element_get_data(index);
+	
+	memset(new_text, 0, log->line_length);
+	for (i = 0; i < log->line_length && text[i] && text[i] != '\n'; i++)
+		new_text[i] = (unsigned char) text[i];
+	
+	if (log->count < log->line_count)
+	{
+		/*
+		// the log is not full yet so the line goes bellow
+		// the last one
+		*/
+		line = log->count++;
+		slot = LG_LOG_LINE(log, log->first + line);
+		lg_log_invalidate_line(log, line, slot, new_text);
+		memcpy(slot, new_text, log->line_length);
+	}
+	else if (log->mode == LG_LOG_WRAP)
+	{
+		/*
+		// the line replaces the oldest one in place
+		*/
+		line = log->first;
+		slot = LG_LOG_LINE(log, line);
+		lg_log_invalidate_line(log, line, slot, new_text);
+		memcpy(slot, new_text, log->line_length);
+		if (++log->first == log->line_count)
+			log->first = 0;
+	}
+	else
+	{
+		/*
+		// all lines move up one line. If the display can scroll the
+		// log only the new line is painted, otherwise we repaint only
+		// the characters that change on each line
+		*/
+		lg_begin_update();
+		if (lg_element_scroll(index, 0, -8 * log->size))
+		{
+			lg_element_invalidate_rect(index, log->x, log->y + (log->line_count - 1) * 8 * log->size, 
+				(uint16_t) log->line_length * 8 * log->size, 8 * log->size);
+		}
+		else
+		{
+			for (line = 0; line < log->line_count - 1; line++)
+			{
+				lg_log_invalidate_line(log, line, LG_LOG_LINE(log, log->first + line), 
+					LG_LOG_LINE(log, log->first + line + 1));
+			}
+			lg_log_invalidate_line(log, line, LG_LOG_LINE(log, log->first + line), new_text);
+		}
+		memcpy(LG_LOG_LINE(log, log->first), new_text, log->line_length);
+		if (++log->first == log->line_count)
+			log->first = 0;
+		lg_end_update();
+	}
+}
+
+/*
+// removes all lines from a log
+*/
+void lg_log_clear(uint16_t index)
+{
+	LG_LOG* log = (LG_LOG*) lg_element_get_data(index);
+	memset(log->lines, 0, (uint16_t) log->line_count * log->line_length);
+	log->first = 0;
+	log->count = 0;
+	lg_element_invalidate(index);
+}
+
+/*
+// renders a span of a log. In wrap mode the lines are drawn in
+// the order they are stored, in scroll mode starting with the
+// oldest one
+*/
+static void lg_log_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span)
+{
+	uint16_t i;
+	uint16_t row;
+	uint16_t column;
+	uint16_t char_x;
+	unsigned char line;
+	unsigned char font_row;
+	const unsigned char* text;
+	LG_LOG* log = (LG_LOG*) data;
+	
+	row = y - log->y;
+	line = row / (8 * log->size);
+	font_row = (row - line * 8 * log->size) / log->size;
+	if (log->mode == LG_LOG_WRAP)
+		text = LG_LOG_LINE(log, line);
+	else
+		text = LG_LOG_LINE(log, log->first + line);
+	
+	column = (x - log->x) / (8 * log->size);
+	char_x = (x - log->x) - column * 8 * log->size;
+	
+	for (i = 0; i < width; i++)
+	{
+		span[i] = log->background;
+		if (text[column] && LG_GLYPH_PIXEL(text[column], font_row, char_x / log->size))
+		{
+			span[i] = log->color;
+		}
+		if (++char_x == 8 * log->size)
+		{
+			char_x = 0;
+			column++;
+		}
+	}
+}
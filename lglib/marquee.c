@@ -0,0 +1,230 @@
+/*
+ * lglib - Lightweight Graphics Library for Embedded Systems
+ * Copyright (C) 2013 Fernando Rodriguez (support@fernansoft.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "font.h"
+#include <string.h>
+#include "lg.h"
+#include "element.h"
+
+#define LG_MAX_MARQUEES		2
+
+typedef struct LG_MARQUEE
+{
+	char in_use;
+	int16_t index;
+	uint16_t x;
+	uint16_t y;
+	uint16_t width;
+	unsigned char size;
+	unsigned char step;
+	uint16_t period;
+	uint32_t last_tick;
+	uint16_t length;
+	uint16_t max_length;
+	uint16_t text_width;
+	uint16_t total_width;
+	uint16_t offset;
+	LG_RGB color;
+	LG_RGB background;
+	unsigned char* masks;
+}
+LG_MARQUEE;
+
+static LG_MARQUEE marquees[LG_MAX_MARQUEES];
+
+/*
+// prototypes
+*/
+static void lg_marquee_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span);
+static void lg_marquee_release(void* data);
+
+static const LG_ELEMENT_OPS marquee_ops = { lg_marquee_render, lg_marquee_release };
+
+/*
+// builds the row masks of the text. Each font row of the whole
+// text is stored as a contiguous row of bits so rendering a
+// scanline doesn't have to look up the font
+*/
+static void lg_marquee_build(LG_MARQUEE* marquee, const char* text)
+{
+	uint16_t i;
+	unsigned char row;
+	unsigned char c;
+	
+	marquee->length = strlen(text);
+	if (marquee->length > marquee->max_length)
+		marquee->length = marquee->max_length;
+	for (i = 0; i < marquee->length; i++)
+	{
+		c = (unsigned char) text[i];
+		for (row = 0; row < 8; row++)
+			marquee->masks[row * marquee->length + i] = LG_GLYPH_ROW(c, row);
+	}
+	/*
+	// the text scrolls all the way out of the marquee
+	// before it comes back
+	*/
+	marquee->text_width = marquee->length * 8 * marquee->size;
+	marquee->total_width = marquee->text_width + marquee->width;
+	marquee->offset = 0;
+}
+
+/*
+// adds a marquee to the display
+*/
+int16_t lg_marquee_add(const char* text, unsigned char* masks, uint16_t max_length, uint16_t x, uint16_t y, 
+	uint16_t width, unsigned char font_size, unsigned char step, uint16_t period, LG_RGB color, LG_RGB background)
+{
+	int16_t i;
+	
+	/*
+	// the text scrolls through the width of the marquee so
+	// it can't be empty
+	*/
+	if (!width || !font_size)
+		return -1;
+	
+	for (i = 0; i < LG_MAX_MARQUEES; i++)
+	{
+		if (!marquees[i].in_use)
+		{
+			marquees[i].masks = masks;
+			marquees[i].max_length = max_length;
+			marquees[i].x = x;
+			marquees[i].y = y;
+			marquees[i].width = width;
+			marquees[i].size = font_size;
+			marquees[i].step = step;
+			marquees[i].period = period;
+			marquees[i].last_tick = 0;
+			marquees[i].color = color;
+			marquees[i].background = background;
+			lg_marquee_build(&marquees[i], text);
+			marquees[i].index = lg_element_add(&marquee_ops, &marquees[i], LG_LAYER_CONTENT, 
+				x, y, width, 8 * font_size);
+			if (marquees[i].index >= 0)
+				marquees[i].in_use = 1;
+			return marquees[i].index;
+		}
+	}
+	return -1;
+}
+
+/*
+// releases a marquee
+*/
+static void lg_marquee_release(void* data)
+{
+	((LG_MARQUEE*) data)->in_use = 0;
+}
+
+/*
+// changes the text of a marquee, it starts again from the
+// beginning
+*/
+void lg_marquee_set_text(uint16_t index, const char* text)
+{
+	LG_MARQUEE* marquee = (LG_MARQUEE*) lg_element_get_data(index);
+	lg_marquee_build(marquee, text);
+	lg_element_invalidate(index);
+}
+
+/*
+// advances all marquees whose period has elapsed. Nothing moves
+// while the display is busy painting so we never queue more than
+// one step of each marquee
+*/
+char lg_marquee_process(uint32_t now)
+{
+	unsigned char i;
+	char active = 0;
+	LG_MARQUEE* marquee;
+	
+	for (i = 0; i < LG_MAX_MARQUEES; i++)
+		active |= marquees[i].in_use;
+	if (!active || lg_display_is_busy())
+		return active;
+	
+	lg_begin_update();
+	for (i = 0; i < LG_MAX_MARQUEES; i++)
+	{
+		marquee = &marquees[i];
+		if (!marquee->in_use || now - marquee->last_tick < marquee->period)
+			continue;
+		
+		marquee->last_tick = now;
+		marquee->offset += marquee->step;
+		if (marquee->offset >= marquee->total_width)
+			marquee->offset -= marquee->total_width;
+		/*
+		// if the display can scroll the marquee only the
+		// columns that come in need to be painted
+		*/
+		if (marquee->step < marquee->width && lg_element_scroll(marquee->index, -marquee->step, 0))
+		{
+			lg_element_invalidate_rect(marquee->index, marquee->x + marquee->width - marquee->step, 
+				marquee->y, marquee->step, 8 * marquee->size);
+		}
+		else
+		{
+			lg_element_invalidate(marquee->index);
+		}
+	}
+	lg_end_update();
+	return active;
+}
+
+/*
+// renders a span of a marquee
+*/
+static void lg_marquee_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span)
+{
+	uint16_t i;
+	uint16_t t;
+	uint16_t bit;
+	unsigned char sub;
+	const unsigned char* masks;
+	LG_MARQUEE* marquee = (LG_MARQUEE*) data;
+	
+	masks = &marquee->masks[((y - marquee->y) / marquee->size) * marquee->length];
+	t = (uint16_t) (((uint32_t) marquee->offset + (x - marquee->x)) % marquee->total_width);
+	bit = t / marquee->size;
+	sub = t - bit * marquee->size;
+	
+	for (i = 0; i < width; i++)
+	{
+		if (t < marquee->text_width && (masks[bit >> 3] & (0x80 >> (bit & 7))))
+			span[i] = marquee->color;
+		else
+			span[i] = marquee->background;
+		
+		if (++sub == marquee->size)
+		{
+			sub = 0;
+			bit++;
+		}
+		if (++t == marquee->total_width)
+		{
+			t = 0;
+			bit = 0;
+			sub = 0;
+		}
+	}
+}
@@ -0,0 +1,365 @@
+/*
+ * lglib - Lightweight Graphics Library for Embedded Systems
+ * Copyright (C) 2013 Fernando Rodriguez (support@fernansoft.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "lg.h"
+#include "element.h"
+
+#define LG_MAX_POLYGONS				4
+#define LG_MAX_POLYGON_EDGES		64		/* total for all polygons */
+#define LG_MAX_POLYGON_ACTIVE		8		/* max edges crossing a scanline */
+
+typedef struct LG_EDGE
+{
+	int16_t y_min;
+	int16_t y_max;
+	int32_t x;			/* x at the center of row y_min (16.16) */
+	int32_t step;		/* dx / dy (16.16) */
+}
+LG_EDGE;
+
+typedef struct LG_POLYGON
+{
+	char in_use;
+	int16_t index;
+	const LG_POINT* points;
+	unsigned char count;
+	int16_t x;
+	int16_t y;
+	LG_RGB color;
+	/*
+	// edge table sorted by y_min
+	*/
+	unsigned char first_edge;
+	unsigned char edge_count;
+	unsigned char next_edge;
+	/*
+	// active edge table sorted by x
+	*/
+	int16_t active_y;
+	unsigned char active_count;
+	unsigned char active[LG_MAX_POLYGON_ACTIVE];
+	int32_t active_x[LG_MAX_POLYGON_ACTIVE];
+}
+LG_POLYGON;
+
+static LG_POLYGON polygons[LG_MAX_POLYGONS];
+static LG_EDGE edges[LG_MAX_POLYGON_EDGES];
+
+/*
+// prototypes
+*/
+static void lg_polygon_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span);
+static void lg_polygon_release(void* data);
+
+static const LG_ELEMENT_OPS polygon_ops = { lg_polygon_render, lg_polygon_release };
+
+/*
+// finds a free range on the edge table
+*/
+static int16_t lg_edges_alloc(unsigned char count)
+{
+	int16_t start = 0;
+	int16_t i;
+	
+	while (start + count <= LG_MAX_POLYGON_EDGES)
+	{
+		for (i = 0; i < LG_MAX_POLYGONS; i++)
+		{
+			if (polygons[i].in_use && 
+				start < polygons[i].first_edge + polygons[i].count &&
+				start + count > polygons[i].first_edge)
+			{
+				start = polygons[i].first_edge + polygons[i].count;
+				break;
+			}
+		}
+		if (i == LG_MAX_POLYGONS)
+			return start;
+	}
+	return -1;
+}
+
+/*
+// builds the edge table of a polygon
+*/
+static void lg_polygon_build_edges(LG_POLYGON* polygon)
+{
+	unsigned char i;
+	unsigned char j;
+	int16_t x1;
+	int16_t y1;
+	int16_t x2;
+	int16_t y2;
+	LG_EDGE edge;
+	LG_EDGE* table = &edges[polygon->first_edge];
+	
+	polygon->edge_count = 0;
+	
+	for (i = 0; i < polygon->count; i++)
+	{
+		x1 = polygon->x + polygon->points[i].x;
+		y1 = polygon->y + polygon->points[i].y;
+		x2 = polygon->x + polygon->points[(i + 1) % polygon->count].x;
+		y2 = polygon->y + polygon->points[(i + 1) % polygon->count].y;
+		/*
+		// horizontal edges never cross a scanline
+		*/
+		if (y1 == y2)
+			continue;
+		if (y1 > y2)
+		{
+			edge.x = x1; x1 = x2; x2 = (int16_t) edge.x;
+			edge.y_min = y1; y1 = y2; y2 = edge.y_min;
+		}
+		/*
+		// the edge covers the rows whose centers are within [y1, y2)
+		*/
+		edge.y_min = y1;
+		edge.y_max = y2;
+		edge.step = ((int32_t) (x2 - x1) << 16) / (y2 - y1);
+		edge.x = ((int32_t) x1 << 16) + (edge.step >> 1);
+		/*
+		// insert it sorted by y_min
+		*/
+		for (j = polygon->edge_count; j > 0 && table[j - 1].y_min > edge.y_min; j--)
+			table[j] = table[j - 1];
+		table[j] = edge;
+		polygon->edge_count++;
+	}
+	polygon->active_y = -2;
+	polygon->active_count = 0;
+	polygon->next_edge = 0;
+}
+
+/*
+// calculates the bounds of a polygon
+*/
+static void lg_polygon_bounds(LG_POLYGON* polygon, uint16_t* x, uint16_t* y, uint16_t* width, uint16_t* height)
+{
+	unsigned char i;
+	int16_t x_min = polygon->points[0].x;
+	int16_t y_min = polygon->points[0].y;
+	int16_t x_max = x_min;
+	int16_t y_max = y_min;
+	
+	for (i = 1; i < polygon->count; i++)
+	{
+		x_min = MIN(x_min, polygon->points[i].x);
+		y_min = MIN(y_min, polygon->points[i].y);
+		x_max = MAX(x_max, polygon->points[i].x);
+		y_max = MAX(y_max, polygon->points[i].y);
+	}
+	*x = polygon->x + x_min;
+	*y = polygon->y + y_min;
+	*width = x_max - x_min;
+	*height = y_max - y_min;
+}
+
+/*
+// adds a filled polygon to the display. The points are relative to (x, y)
+// and are not copied so they must remain valid while the polygon exists
+*/
+int16_t lg_polygon_add(const LG_POINT* points, unsigned char count, uint16_t x, uint16_t y, LG_RGB color)
+{
+	int16_t i;
+	int16_t first_edge;
+	uint16_t bounds_x;
+	uint16_t bounds_y;
+	uint16_t bounds_width;
+	uint16_t bounds_height;
+	
+	if (count < 3)
+		return -1;
+	
+	for (i = 0; i < LG_MAX_POLYGONS; i++)
+	{
+		if (!polygons[i].in_use)
+		{
+			first_edge = lg_edges_alloc(count);
+			if (first_edge < 0)
+				return -1;
+			
+			polygons[i].points = points;
+			polygons[i].count = count;
+			polygons[i].x = x;
+			polygons[i].y = y;
+			polygons[i].color = color;
+			polygons[i].first_edge = (unsigned char) first_edge;
+			lg_polygon_build_edges(&polygons[i]);
+			lg_polygon_bounds(&polygons[i], &bounds_x, &bounds_y, &bounds_width, &bounds_height);
+			
+			polygons[i].index = lg_element_add(&polygon_ops, &polygons[i], LG_LAYER_CONTENT, 
+				bounds_x, bounds_y, bounds_width, bounds_height);
+			if (polygons[i].index >= 0)
+				polygons[i].in_use = 1;
+			return polygons[i].index;
+		}
+	}
+	return -1;
+}
+
+/*
+// releases a polygon
+*/
+static void lg_polygon_release(void* data)
+{
+	((LG_POLYGON*) data)->in_use = 0;
+}
+
+/*
+// moves a polygon
+*/
+void lg_polygon_set_position(uint16_t index, uint16_t x, uint16_t y)
+{
+	uint16_t bounds_x;
+	uint16_t bounds_y;
+	uint16_t bounds_width;
+	uint16_t bounds_height;
+	LG_POLYGON* polygon = (LG_POLYGON*) lg_element_get_data(index);
+	
+	polygon->x = x;
+	polygon->y = y;
+	lg_polygon_build_edges(polygon);
+	lg_polygon_bounds(polygon, &bounds_x, &bounds_y, &bounds_width, &bounds_height);
+	lg_element_set_bounds(index, bounds_x, bounds_y, bounds_width, bounds_height);
+}
+
+/*
+// sets the color of a polygon
+*/
+void lg_polygon_set_color(uint16_t index, LG_RGB color)
+{
+	LG_POLYGON* polygon = (LG_POLYGON*) lg_element_get_data(index);
+	if (polygon->color != color)
+	{
+		polygon->color = color;
+		lg_element_invalidate(index);
+	}
+}
+
+/*
+// updates the active edge table for a scanline. When scanlines are
+// rendered in order (the common case) we just step the active edges
+// and add the ones that start on this row, otherwise we rebuild it
+*/
+static void lg_polygon_update_active(LG_POLYGON* polygon, int16_t y)
+{
+	unsigned char i;
+	unsigned char j;
+	unsigned char edge;
+	int32_t edge_x;
+	LG_EDGE* table = &edges[polygon->first_edge];
+	
+	if (y == polygon->active_y)
+		return;
+	
+	if (y == polygon->active_y + 1)
+	{
+		/*
+		// step the active edges and drop the ones that end here
+		*/
+		for (i = 0, j = 0; i < polygon->active_count; i++)
+		{
+			if (table[polygon->active[i]].y_max > y)
+			{
+				polygon->active[j] = polygon->active[i];
+				polygon->active_x[j] = polygon->active_x[i] + table[polygon->active[i]].step;
+				j++;
+			}
+		}
+		polygon->active_count = j;
+	}
+	else
+	{
+		/*
+		// rebuild the active edge table
+		*/
+		polygon->active_count = 0;
+		polygon->next_edge = 0;
+		while (polygon->next_edge < polygon->edge_count && table[polygon->next_edge].y_min < y)
+		{
+			edge = polygon->next_edge++;
+			if (table[edge].y_max > y && polygon->active_count < LG_MAX_POLYGON_ACTIVE)
+			{
+				polygon->active[polygon->active_count] = edge;
+				polygon->active_x[polygon->active_count] = table[edge].x + table[edge].step * (y - table[edge].y_min);
+				polygon->active_count++;
+			}
+		}
+	}
+	/*
+	// add the edges that start on this row
+	*/
+	while (polygon->next_edge < polygon->edge_count && table[polygon->next_edge].y_min <= y)
+	{
+		edge = polygon->next_edge++;
+		if (table[edge].y_max > y && polygon->active_count < LG_MAX_POLYGON_ACTIVE)
+		{
+			polygon->active[polygon->active_count] = edge;
+			polygon->active_x[polygon->active_count] = table[edge].x + table[edge].step * (y - table[edge].y_min);
+			polygon->active_count++;
+		}
+	}
+	/*
+	// keep the table sorted by x, since it's almost sorted from the
+	// previous row insertion sort does very little work
+	*/
+	for (i = 1; i < polygon->active_count; i++)
+	{
+		edge = polygon->active[i];
+		edge_x = polygon->active_x[i];
+		for (j = i; j > 0 && polygon->active_x[j - 1] > edge_x; j--)
+		{
+			polygon->active[j] = polygon->active[j - 1];
+			polygon->active_x[j] = polygon->active_x[j - 1];
+		}
+		polygon->active[j] = edge;
+		polygon->active_x[j] = edge_x;
+	}
+	polygon->active_y = y;
+}
+
+/*
+// renders a span of a polygon. Each pair of active edges is a run
+// of pixels (even-odd rule)
+*/
+static void lg_polygon_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span)
+{
+	unsigned char i;
+	int16_t run_start;
+	int16_t run_end;
+	LG_POLYGON* polygon = (LG_POLYGON*) data;
+	
+	lg_polygon_update_active(polygon, y);
+	
+	for (i = 0; i + 1 < polygon->active_count; i += 2)
+	{
+		/*
+		// a pixel is filled if it's center lies between the edges
+		*/
+		run_start = (int16_t) ((polygon->active_x[i] + 0x7FFF) >> 16);
+		run_end = (int16_t) ((polygon->active_x[i + 1] + 0x7FFF) >> 16);
+		run_start = MAX(run_start, (int16_t) x);
+		run_end = MIN(run_end, (int16_t) (x + width));
+		
+		for (; run_start < run_end; run_start++)
+			span[run_start - x] = polygon->color;
+	}
+}
@@ -0,0 +1,253 @@
+/*
+ * lglib - Lightweight Graphics Library for Embedded Systems
+ * Copyright (C) 2013 Fernando Rodriguez (support@fernansoft.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <string.h>
+#include "lg.h"
+#include "element.h"
+
+#define LG_MAX_QOI_IMAGES	2
+
+#define QOI_HEADER_SIZE		14
+#define QOI_OP_INDEX		0x00
+#define QOI_OP_DIFF			0x40
+#define QOI_OP_LUMA			0x80
+#define QOI_OP_RUN			0xC0
+#define QOI_OP_RGB			0xFE
+#define QOI_OP_RGBA			0xFF
+#define QOI_MASK_2			0xC0
+#define QOI_HASH(px)		((px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) & 63)
+
+typedef struct LG_QOI_IMAGE
+{
+	char in_use;
+	int16_t index;
+	uint16_t x;
+	uint16_t y;
+	LG_QOI* qoi;
+}
+LG_QOI_IMAGE;
+
+static LG_QOI_IMAGE qoi_images[LG_MAX_QOI_IMAGES];
+
+/*
+// prototypes
+*/
+static void lg_qoi_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span);
+static void lg_qoi_release(void* data);
+
+static const LG_ELEMENT_OPS qoi_ops = { lg_qoi_render, lg_qoi_release };
+
+/*
+// rewinds the decoder to the first pixel
+*/
+void lg_qoi_rewind(LG_QOI* qoi)
+{
+	lg_stream_seek(&qoi->stream, QOI_HEADER_SIZE);
+	qoi->position = 0;
+	qoi->run = 0;
+	qoi->px[0] = 0;
+	qoi->px[1] = 0;
+	qoi->px[2] = 0;
+	qoi->px[3] = 255;
+	memset(qoi->index, 0, sizeof(qoi->index));
+}
+
+/*
+// reads the image header
+*/
+static char lg_qoi_open_stream(LG_QOI* qoi)
+{
+	unsigned char i;
+	unsigned char header[QOI_HEADER_SIZE];
+	
+	lg_stream_seek(&qoi->stream, 0);
+	for (i = 0; i < QOI_HEADER_SIZE; i++)
+		header[i] = lg_stream_byte(&qoi->stream);
+	
+	if (header[0] != 'q' || header[1] != 'o' || header[2] != 'i' || header[3] != 'f')
+		return 0;
+	/*
+	// we can't display images larger than 64K pixels wide or tall
+	*/
+	if (header[4] || header[5] || header[8] || header[9])
+		return 0;
+	
+	qoi->width = ((uint16_t) header[6] << 8) | header[7];
+	qoi->height = ((uint16_t) header[10] << 8) | header[11];
+	lg_qoi_rewind(qoi);
+	return 1;
+}
+
+/*
+// opens a QOI image in memory
+*/
+char lg_qoi_open_memory(LG_QOI* qoi, const unsigned char* data, uint32_t size)
+{
+	lg_stream_open_memory(&qoi->stream, data, size);
+	return lg_qoi_open_stream(qoi);
+}
+
+/*
+// opens a QOI image that is read through a callback
+*/
+char lg_qoi_open(LG_QOI* qoi, LG_STREAM_READ read, void* context)
+{
+	lg_stream_open(&qoi->stream, read, context);
+	return lg_qoi_open_stream(qoi);
+}
+
+/*
+// decodes the next chunk. On return qoi->px holds the pixel and
+// qoi->run the number of times it repeats after this one
+*/
+static void lg_qoi_next_chunk(LG_QOI* qoi)
+{
+	unsigned char b1;
+	unsigned char b2;
+	signed char vg;
+	unsigned char* px = qoi->px;
+	
+	b1 = lg_stream_byte(&qoi->stream);
+	
+	if (b1 == QOI_OP_RGB)
+	{
+		px[0] = lg_stream_byte(&qoi->stream);
+		px[1] = lg_stream_byte(&qoi->stream);
+		px[2] = lg_stream_byte(&qoi->stream);
+	}
+	else if (b1 == QOI_OP_RGBA)
+	{
+		px[0] = lg_stream_byte(&qoi->stream);
+		px[1] = lg_stream_byte(&qoi->stream);
+		px[2] = lg_stream_byte(&qoi->stream);
+		px[3] = lg_stream_byte(&qoi->stream);
+	}
+	else if ((b1 & QOI_MASK_2) == QOI_OP_INDEX)
+	{
+		memcpy(px, qoi->index[b1], 4);
+	}
+	else if ((b1 & QOI_MASK_2) == QOI_OP_DIFF)
+	{
+		px[0] += ((b1 >> 4) & 0x03) - 2;
+		px[1] += ((b1 >> 2) & 0x03) - 2;
+		px[2] += (b1 & 0x03) - 2;
+	}
+	else if ((b1 & QOI_MASK_2) == QOI_OP_LUMA)
+	{
+		b2 = lg_stream_byte(&qoi->stream);
+		vg = (b1 & 0x3F) - 32;
+		px[0] += vg - 8 + ((b2 >> 4) & 0x0F);
+		px[1] += vg;
+		px[2] += vg - 8 + (b2 & 0x0F);
+	}
+	else
+	{
+		qoi->run = b1 & 0x3F;
+	}
+	memcpy(qoi->index[QOI_HASH(px)], px, 4);
+}
+
+/*
+// skips pixels, runs are skipped without decoding
+*/
+static void lg_qoi_skip(LG_QOI* qoi, uint32_t pixels)
+{
+	unsigned char n;
+	
+	while (pixels)
+	{
+		if (qoi->run)
+		{
+			n = (unsigned char) MIN(pixels, qoi->run);
+			qoi->run -= n;
+			qoi->position += n;
+			pixels -= n;
+		}
+		else
+		{
+			lg_qoi_next_chunk(qoi);
+			qoi->position++;
+			pixels--;
+		}
+	}
+}
+
+/*
+// decodes a span of pixels of a row. Rows and spans should be read in
+// order, reading a pixel before the current position rewinds the stream
+*/
+void lg_qoi_read_span(LG_QOI* qoi, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span)
+{
+	uint32_t position = (uint32_t) y * qoi->width + x;
+	
+	if (position < qoi->position)
+		lg_qoi_rewind(qoi);
+	lg_qoi_skip(qoi, position - qoi->position);
+	
+	while (width--)
+	{
+		if (qoi->run)
+			qoi->run--;
+		else
+			lg_qoi_next_chunk(qoi);
+		qoi->position++;
+		*span++ = ((LG_RGB) qoi->px[0] << 16) | ((LG_RGB) qoi->px[1] << 8) | qoi->px[2];
+	}
+}
+
+/*
+// adds a QOI image to the display
+*/
+int16_t lg_qoi_add(LG_QOI* qoi, uint16_t x, uint16_t y)
+{
+	int16_t i;
+	for (i = 0; i < LG_MAX_QOI_IMAGES; i++)
+	{
+		if (!qoi_images[i].in_use)
+		{
+			qoi_images[i].qoi = qoi;
+			qoi_images[i].x = x;
+			qoi_images[i].y = y;
+			qoi_images[i].index = lg_element_add(&qoi_ops, &qoi_images[i], LG_LAYER_CONTENT, 
+				x, y, qoi->width, qoi->height);
+			if (qoi_images[i].index >= 0)
+				qoi_images[i].in_use = 1;
+			return qoi_images[i].index;
+		}
+	}
+	return -1;
+}
+
+/*
+// releases a QOI image
+*/
+static void lg_qoi_release(void* data)
+{
+	((LG_QOI_IMAGE*) data)->in_use = 0;
+}
+
+/*
+// renders a span of a QOI image
+*/
+static void lg_qoi_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span)
+{
+	LG_QOI_IMAGE* image = (LG_QOI_IMAGE*) data;
+	lg_qoi_read_span(image->qoi, x - image->x, y - image->y, width, span);
+}
@@ -0,0 +1,557 @@
+/*
+ * lglib - Lightweight Graphics Library for Embedded Systems
+ * Copyright (C) 2013 Fernando Rodriguez (support@fernansoft.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <string.h>
+#include "lg.h"
+#include "element.h"
+
+#define LG_MAX_SHAPES		16
+#define LG_MAX_CORNER_MASKS	4
+#define LG_MAX_CORNER_RADIUS	32
+
+#define LG_SHAPE_RECT		0
+#define LG_SHAPE_FRAME		1
+#define LG_SHAPE_LINE		2
+#define LG_SHAPE_ROUNDED	3
+
+/*
+// the corner mask holds the number of pixels that are outside
+// of the rounded corner on each row and the coverage of the first
+// pixel inside
+*/
+typedef struct LG_CORNER_MASK
+{
+	unsigned char radius;
+	unsigned char refs;
+	unsigned char inset[LG_MAX_CORNER_RADIUS];
+	unsigned char coverage[LG_MAX_CORNER_RADIUS];
+}
+LG_CORNER_MASK;
+
+typedef struct LG_SHAPE
+{
+	char in_use;
+	unsigned char type;
+	unsigned char thickness;
+	signed char sx;
+	char antialias;
+	unsigned char radius;
+	unsigned char mask;
+	int16_t index;
+	int16_t label;
+	int16_t x;
+	int16_t y;
+	int16_t width;
+	int16_t height;
+	LG_RGB color;
+}
+LG_SHAPE;
+
+static LG_SHAPE shapes[LG_MAX_SHAPES];
+static LG_CORNER_MASK corner_masks[LG_MAX_CORNER_MASKS];
+
+/*
+// prototypes
+*/
+static void lg_rect_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span);
+static void lg_frame_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span);
+static void lg_line_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span);
+static void lg_rounded_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span);
+static void lg_shape_release(void* data);
+
+static const LG_ELEMENT_OPS rect_ops = { lg_rect_render, lg_shape_release };
+static const LG_ELEMENT_OPS frame_ops = { lg_frame_render, lg_shape_release };
+static const LG_ELEMENT_OPS line_ops = { lg_line_render, lg_shape_release };
+static const LG_ELEMENT_OPS rounded_ops = { lg_rounded_render, lg_shape_release };
+
+/*
+// allocates a shape and adds it to the display
+*/
+static int16_t lg_shape_add(const LG_ELEMENT_OPS* ops, unsigned char type, 
+	uint16_t x, uint16_t y, uint16_t width, uint16_t height, LG_RGB color)
+{
+	int16_t i;
+	for (i = 0; i < LG_MAX_SHAPES; i++)
+	{
+		if (!shapes[i].in_use)
+		{
+			shapes[i].type = type;
+			shapes[i].x = x;
+			shapes[i].y = y;
+			shapes[i].width = width;
+			shapes[i].height = height;
+			shapes[i].color = color;
+			shapes[i].thickness = 1;
+			shapes[i].sx = 1;
+			shapes[i].label = -1;
+			shapes[i].index = lg_element_add(ops, &shapes[i], LG_LAYER_CONTENT, x, y, width, height);
+			if (shapes[i].index >= 0)
+				shapes[i].in_use = 1;
+			return shapes[i].index;
+		}
+	}
+	return -1;
+}
+
+/*
+// releases a shape slot
+*/
+static void lg_shape_release(void* data)
+{
+	LG_SHAPE* shape = (LG_SHAPE*) data;
+	
+	if (shape->type == LG_SHAPE_ROUNDED)
+		corner_masks[shape->mask].refs--;
+	if (shape->label >= 0)
+		lg_element_remove(shape->label);
+	shape->in_use = 0;
+}
+
+/*
+// repaints the edges of a frame
+*/
+static void lg_frame_invalidate(LG_SHAPE* shape)
+{
+	if (shape->thickness * 2 >= shape->width || shape->thickness * 2 >= shape->height)
+	{
+		lg_element_invalidate(shape->index);
+		return;
+	}
+	lg_element_invalidate_rect(shape->index, shape->x, shape->y, shape->width, shape->thickness);
+	lg_element_invalidate_rect(shape->index, shape->x, shape->y + shape->height - shape->thickness, 
+		shape->width, shape->thickness);
+	lg_element_invalidate_rect(shape->index, shape->x, shape->y + shape->thickness, 
+		shape->thickness, shape->height - (shape->thickness * 2));
+	lg_element_invalidate_rect(shape->index, shape->x + shape->width - shape->thickness, 
+		shape->y + shape->thickness, shape->thickness, shape->height - (shape->thickness * 2));
+}
+
+/*
+// adds a filled rectangle to the display
+*/
+int16_t lg_rect_add(uint16_t x, uint16_t y, uint16_t width, uint16_t height, LG_RGB color)
+{
+	return lg_shape_add(&rect_ops, LG_SHAPE_RECT, x, y, width, height, color);
+}
+
+/*
+// adds a horizontal line to the display
+*/
+int16_t lg_hline_add(uint16_t x, uint16_t y, uint16_t length, LG_RGB color)
+{
+	return lg_shape_add(&rect_ops, LG_SHAPE_RECT, x, y, length, 1, color);
+}
+
+/*
+// adds a vertical line to the display
+*/
+int16_t lg_vline_add(uint16_t x, uint16_t y, uint16_t length, LG_RGB color)
+{
+	return lg_shape_add(&rect_ops, LG_SHAPE_RECT, x, y, 1, length, color);
+}
+
+/*
+// adds a rectangular frame to the display
+*/
+int16_t lg_frame_add(uint16_t x, uint16_t y, uint16_t width, uint16_t height, 
+	unsigned char thickness, LG_RGB color)
+{
+	int16_t index;
+	index = lg_shape_add(&frame_ops, LG_SHAPE_FRAME, x, y, width, height, color);
+	if (index >= 0)
+		((LG_SHAPE*) lg_element_get_data(index))->thickness = thickness;
+	return index;
+}
+
+/*
+// sets the end points of a line
+*/
+static void lg_line_set(LG_SHAPE* shape, int16_t x1, int16_t y1, int16_t x2, int16_t y2)
+{
+	/*
+	// lines are always stored top to bottom with the
+	// horizontal direction in sx
+	*/
+	if (y2 < y1)
+	{
+		shape->x = x2;
+		shape->y = y2;
+		shape->width = x1 - x2;
+		shape->height = y1 - y2;
+	}
+	else
+	{
+		shape->x = x1;
+		shape->y = y1;
+		shape->width = x2 - x1;
+		shape->height = y2 - y1;
+	}
+	shape->sx = 1;
+	if (shape->width < 0)
+	{
+		shape->width = -shape->width;
+		shape->sx = -1;
+	}
+}
+
+/*
+// adds a line to the display
+*/
+int16_t lg_line_add(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, LG_RGB color)
+{
+	int16_t index;
+	index = lg_shape_add(&line_ops, LG_SHAPE_LINE, MIN(x1, x2), MIN(y1, y2), 
+		(MAX(x1, x2) - MIN(x1, x2)) + 1, (MAX(y1, y2) - MIN(y1, y2)) + 1, color);
+	if (index >= 0)
+		lg_line_set((LG_SHAPE*) lg_element_get_data(index), x1, y1, x2, y2);
+	return index;
+}
+
+/*
+// changes the end points of a line
+*/
+void lg_line_set_points(uint16_t index, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2)
+{
+	LG_SHAPE* shape = (LG_SHAPE*) lg_element_get_data(index);
+	lg_line_set(shape, x1, y1, x2, y2);
+	lg_element_set_bounds(index, MIN(x1, x2), MIN(y1, y2), 
+		(MAX(x1, x2) - MIN(x1, x2)) + 1, (MAX(y1, y2) - MIN(y1, y2)) + 1);
+}
+
+/*
+// changes the bounds of a rectangle or frame
+*/
+void lg_shape_set_bounds(uint16_t index, uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+	LG_SHAPE* shape = (LG_SHAPE*) lg_element_get_data(index);
+	
+	if (shape->type == LG_SHAPE_FRAME)
+	{
+		/*
+		// only the edges of a frame need to be repainted
+		*/
+		lg_frame_invalidate(shape);
+		shape->x = x;
+		shape->y = y;
+		shape->width = width;
+		shape->height = height;
+		lg_element_update_bounds(index, x, y, width, height);
+		lg_frame_invalidate(shape);
+	}
+	else if (shape->type == LG_SHAPE_RECT || shape->type == LG_SHAPE_ROUNDED)
+	{
+		shape->x = x;
+		shape->y = y;
+		shape->width = width;
+		shape->height = height;
+		lg_element_set_bounds(index, x, y, width, height);
+	}
+}
+
+/*
+// changes the color of a shape
+*/
+void lg_shape_set_color(uint16_t index, LG_RGB color)
+{
+	LG_SHAPE* shape = (LG_SHAPE*) lg_element_get_data(index);
+	if (shape->color != color)
+	{
+		shape->color = color;
+		if (shape->type == LG_SHAPE_FRAME)
+		{
+			lg_frame_invalidate(shape);
+		}
+		else
+		{
+			lg_element_invalidate(index);
+		}
+	}
+}
+
+/*
+// gets the corner mask for a radius, masks are computed once
+// and shared by all shapes with the same radius
+*/
+static int16_t lg_corner_mask_get(unsigned char radius)
+{
+	int16_t i;
+	int16_t free_mask = -1;
+	int32_t edge;
+	unsigned char row;
+	
+	for (i = 0; i < LG_MAX_CORNER_MASKS; i++)
+	{
+		if (corner_masks[i].refs && corner_masks[i].radius == radius)
+		{
+			corner_masks[i].refs++;
+			return i;
+		}
+		if (!corner_masks[i].refs && free_mask < 0)
+			free_mask = i;
+	}
+	if (free_mask < 0)
+		return -1;
+	/*
+	// for each row find where the circle crosses the center of the row
+	// (all in units of half a pixel) and split it into the number of
+	// pixels that are left out and the coverage of the next one
+	*/
+	for (row = 0; row < radius; row++)
+	{
+		edge = ((int32_t) radius << 8) - lg_isqrt(((int32_t) 4 * radius * radius - 
+			(int32_t) (2 * radius - 2 * row - 1) * (2 * radius - 2 * row - 1)) << 14);
+		corner_masks[free_mask].inset[row] = (unsigned char) (edge >> 8);
+		corner_masks[free_mask].coverage[row] = 0xFF - (unsigned char) (edge & 0xFF);
+	}
+	corner_masks[free_mask].radius = radius;
+	corner_masks[free_mask].refs = 1;
+	return free_mask;
+}
+
+/*
+// adds a rounded rectangle to the display
+*/
+int16_t lg_rounded_rect_add(uint16_t x, uint16_t y, uint16_t width, uint16_t height, 
+	unsigned char radius, char antialias, LG_RGB color)
+{
+	int16_t index;
+	int16_t mask;
+	LG_SHAPE* shape;
+	
+	radius = MIN(radius, MIN(width, height) / 2);
+	radius = MIN(radius, LG_MAX_CORNER_RADIUS);
+	mask = lg_corner_mask_get(radius);
+	if (mask < 0)
+		return -1;
+	
+	index = lg_shape_add(&rounded_ops, LG_SHAPE_ROUNDED, x, y, width, height, color);
+	if (index < 0)
+	{
+		corner_masks[mask].refs--;
+		return -1;
+	}
+	shape = (LG_SHAPE*) lg_element_get_data(index);
+	shape->radius = radius;
+	shape->mask = (unsigned char) mask;
+	shape->antialias = antialias;
+	return index;
+}
+
+/*
+// adds a button to the display
+*/
+int16_t lg_button_add(uint16_t x, uint16_t y, uint16_t width, uint16_t height, unsigned char radius, 
+	LG_RGB color, unsigned char* text, unsigned char font_size, LG_RGB text_color)
+{
+	int16_t index;
+	uint16_t text_width;
+	LG_SHAPE* shape;
+	
+	index = lg_rounded_rect_add(x, y, width, height, radius, 1, color);
+	if (index < 0)
+		return -1;
+	/*
+	// add the text centered on top of the button
+	*/
+	text_width = strlen((char*) text) * 8 * font_size;
+	shape = (LG_SHAPE*) lg_element_get_data(index);
+	shape->label = lg_label_add(text, NULL, font_size, 0, text_color, 
+		x + ((width > text_width) ? (width - text_width) / 2 : 0), 
+		y + ((height > 8 * font_size) ? (height - (8 * font_size)) / 2 : 0));
+	if (shape->label < 0)
+	{
+		lg_element_remove(index);
+		return -1;
+	}
+	lg_element_set_z(shape->label, 1);
+	return index;
+}
+
+/*
+// gets the index of the label of a button
+*/
+int16_t lg_button_get_label(uint16_t index)
+{
+	return ((LG_SHAPE*) lg_element_get_data(index))->label;
+}
+
+/*
+// fills a run of pixels
+*/
+static void lg_fill_run(LG_RGB* span, uint16_t width, LG_RGB color)
+{
+	while (width--)
+		*span++ = color;
+}
+
+/*
+// renders a span of a rectangle. Since the span is already
+// clipped to the element bounds it is a single run
+*/
+static void lg_rect_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span)
+{
+	lg_fill_run(span, width, ((LG_SHAPE*) data)->color);
+}
+
+/*
+// renders a span of a frame
+*/
+static void lg_frame_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span)
+{
+	int16_t run_end;
+	int16_t right;
+	LG_SHAPE* shape = (LG_SHAPE*) data;
+	/*
+	// the top and bottom edges are one run
+	*/
+	if (y < shape->y + shape->thickness || y >= shape->y + shape->height - shape->thickness)
+	{
+		lg_fill_run(span, width, shape->color);
+		return;
+	}
+	/*
+	// everything else is a run for the left edge and 
+	// another for the right
+	*/
+	run_end = shape->x + shape->thickness;
+	if ((int16_t) x < run_end)
+		lg_fill_run(span, MIN(run_end - x, width), shape->color);
+	
+	right = shape->x + shape->width - shape->thickness;
+	if ((int16_t) (x + width) > right)
+	{
+		run_end = MAX(right, (int16_t) x);
+		lg_fill_run(&span[run_end - x], (x + width) - run_end, shape->color);
+	}
+}
+
+/*
+// renders a span of a line. The pixels of a Bresenham line on each
+// row form a single run so we compute it's bounds directly from the
+// midpoint decision rule instead of stepping the line from the start
+*/
+static void lg_line_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span)
+{
+	int16_t r;
+	int16_t t_min;
+	int16_t t_max;
+	int16_t run_start;
+	int16_t run_end;
+	int32_t dx2;
+	int32_t dy2;
+	LG_SHAPE* shape = (LG_SHAPE*) data;
+	
+	r = y - shape->y;
+	dx2 = (int32_t) shape->width * 2;
+	dy2 = (int32_t) shape->height * 2;
+	
+	if (shape->height == 0)
+	{
+		t_min = 0;
+		t_max = shape->width;
+	}
+	else if (shape->width >= shape->height)
+	{
+		/*
+		// x-major, pixel t is on row floor((2 * t * dy + dx) / (2 * dx))
+		*/
+		t_min = (r == 0) ? 0 : (int16_t) (((2 * r - 1) * (int32_t) shape->width + dy2 - 1) / dy2);
+		t_max = (int16_t) (((2 * r + 1) * (int32_t) shape->width + dy2 - 1) / dy2) - 1;
+		t_max = MIN(t_max, shape->width);
+	}
+	else
+	{
+		/*
+		// y-major, one pixel per row
+		*/
+		t_min = t_max = (int16_t) ((r * dx2 + shape->height) / dy2);
+	}
+	
+	if (shape->sx > 0)
+	{
+		run_start = shape->x + t_min;
+		run_end = shape->x + t_max + 1;
+	}
+	else
+	{
+		run_start = shape->x - t_max;
+		run_end = shape->x - t_min + 1;
+	}
+	run_start = MAX(run_start, (int16_t) x);
+	run_end = MIN(run_end, (int16_t) (x + width));
+	
+	if (run_start < run_end)
+		lg_fill_run(&span[run_start - x], run_end - run_start, shape->color);
+}
+
+/*
+// renders a span of a rounded rectangle. Rows within the corners are
+// at most three runs: the anti-aliased edge pixels and the solid run
+// between them
+*/
+static void lg_rounded_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span)
+{
+	int16_t row;
+	int16_t run_start;
+	int16_t run_end;
+	unsigned char coverage;
+	LG_SHAPE* shape = (LG_SHAPE*) data;
+	LG_CORNER_MASK* mask = &corner_masks[shape->mask];
+	
+	row = y - shape->y;
+	if (row >= shape->height - shape->radius)
+		row = shape->height - row - 1;
+	
+	if (row >= shape->radius)
+	{
+		lg_fill_run(span, width, shape->color);
+		return;
+	}
+	
+	run_start = shape->x + mask->inset[row];
+	run_end = shape->x + shape->width - mask->inset[row];
+	coverage = mask->coverage[row];
+	/*
+	// without anti-aliasing the edge pixel is drawn only if
+	// it's center is inside
+	*/
+	if (!shape->antialias)
+	{
+		if (coverage < 0x80)
+		{
+			run_start++;
+			run_end--;
+		}
+		coverage = 0xFF;
+	}
+	if (coverage != 0xFF)
+	{
+		if (run_start >= (int16_t) x && run_start < (int16_t) (x + width))
+			span[run_start - x] = lg_blend(span[run_start - x], shape->color, coverage);
+		if (run_end - 1 >= (int16_t) x && run_end - 1 < (int16_t) (x + width))
+			span[run_end - 1 - x] = lg_blend(span[run_end - 1 - x], shape->color, coverage);
+		run_start++;
+		run_end--;
+	}
+	run_start = MAX(run_start, (int16_t) x);
+	run_end = MIN(run_end, (int16_t) (x + width));
+	if (run_start < run_end)
+		lg_fill_run(&span[run_start - x], run_end - run_start, shape->color);
+}
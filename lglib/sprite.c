@@ -0,0 +1,289 @@
+/*
+ * lglib - Lightweight Graphics Library for Embedded Systems
+ * Copyright (C) 2013 Fernando Rodriguez (support@fernansoft.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "lg.h"
+#include "element.h"
+
+/*
+// the number of sprites may be overriden at compile time, the
+// scanline index uses one bit per sprite
+*/
+#if !defined(LG_MAX_SPRITES)
+#define LG_MAX_SPRITES		8
+#endif
+#define LG_MAX_SPRITE_ROWS	240
+
+#if LG_MAX_SPRITES <= 8
+typedef unsigned char LG_SPRITE_MASK;
+#elif LG_MAX_SPRITES <= 16
+typedef uint16_t LG_SPRITE_MASK;
+#else
+#error LG_MAX_SPRITES cannot be larger than 16
+#endif
+
+typedef struct LG_SPRITE
+{
+	char in_use;
+	char visible;
+	char transparent;
+	uint16_t x;
+	uint16_t y;
+	const LG_BITMAP* bitmap;
+	LG_RLE_CURSOR cursor;
+}
+LG_SPRITE;
+
+static LG_SPRITE sprites[LG_MAX_SPRITES];
+static LG_SPRITE_MASK sprite_rows[LG_MAX_SPRITE_ROWS];
+static int16_t sprite_layer = -1;
+
+/*
+// prototypes
+*/
+static void lg_sprite_layer_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span);
+static void lg_sprite_layer_release(void* data);
+
+static const LG_ELEMENT_OPS sprite_layer_ops = { lg_sprite_layer_render, lg_sprite_layer_release };
+
+/*
+// adds or removes a sprite from the index of every
+// scanline that it covers
+*/
+static void lg_sprite_index(unsigned char index, char set)
+{
+	uint16_t row = sprites[index].y;
+	uint16_t row_end = MIN(row + sprites[index].bitmap->height, LG_MAX_SPRITE_ROWS);
+	LG_SPRITE_MASK bit = (LG_SPRITE_MASK) (1 << index);
+	
+	for (; row < row_end; row++)
+	{
+		if (set)
+			sprite_rows[row] |= bit;
+		else
+			sprite_rows[row] &= ~bit;
+	}
+}
+
+/*
+// updates the bounds of the sprite layer to the union
+// of all visible sprites
+*/
+static void lg_sprite_update_layer(void)
+{
+	unsigned char i;
+	uint16_t x = 0xFFFF;
+	uint16_t y = 0xFFFF;
+	uint16_t x_end = 0;
+	uint16_t y_end = 0;
+	
+	for (i = 0; i < LG_MAX_SPRITES; i++)
+	{
+		if (sprites[i].in_use && sprites[i].visible)
+		{
+			x = MIN(x, sprites[i].x);
+			y = MIN(y, sprites[i].y);
+			x_end = MAX(x_end, sprites[i].x + sprites[i].bitmap->width);
+			y_end = MAX(y_end, sprites[i].y + sprites[i].bitmap->height);
+		}
+	}
+	if (x_end)
+		lg_element_update_bounds(sprite_layer, x, y, x_end - x, y_end - y);
+	else
+		lg_element_update_bounds(sprite_layer, 0, 0, 0, 0);
+}
+
+/*
+// adds a sprite
+*/
+int16_t lg_sprite_add(const LG_BITMAP* bitmap, uint16_t x, uint16_t y, char transparent)
+{
+	int16_t i;
+	
+	/*
+	// all sprites are rendered by a single element on
+	// the overlay layer
+	*/
+	if (sprite_layer < 0)
+	{
+		sprite_layer = lg_element_add(&sprite_layer_ops, NULL, LG_LAYER_OVERLAY, 0, 0, 0, 0);
+		if (sprite_layer < 0)
+			return -1;
+	}
+	
+	for (i = 0; i < LG_MAX_SPRITES; i++)
+	{
+		if (!sprites[i].in_use)
+		{
+			sprites[i].bitmap = bitmap;
+			sprites[i].x = x;
+			sprites[i].y = y;
+			sprites[i].transparent = transparent;
+			sprites[i].visible = 1;
+			sprites[i].in_use = 1;
+			lg_bitmap_rewind(&sprites[i].cursor);
+			lg_sprite_index(i, 1);
+			lg_sprite_update_layer();
+			lg_element_invalidate_rect(sprite_layer, x, y, bitmap->width, bitmap->height);
+			return i;
+		}
+	}
+	return -1;
+}
+
+/*
+// removes a sprite
+*/
+void lg_sprite_remove(uint16_t index)
+{
+	LG_SPRITE* sprite = &sprites[index];
+	
+	if (!sprite->in_use)
+		return;
+	
+	sprite->in_use = 0;
+	if (sprite->visible)
+	{
+		lg_sprite_index(index, 0);
+		lg_sprite_update_layer();
+		lg_element_invalidate_rect(sprite_layer, sprite->x, sprite->y, 
+			sprite->bitmap->width, sprite->bitmap->height);
+	}
+}
+
+/*
+// moves a sprite, the old and new areas are repainted
+// once even if they overlap
+*/
+void lg_sprite_move(uint16_t index, uint16_t x, uint16_t y)
+{
+	uint16_t old_x;
+	uint16_t old_y;
+	LG_SPRITE* sprite = &sprites[index];
+	
+	if (sprite->x == x && sprite->y == y)
+		return;
+	
+	old_x = sprite->x;
+	old_y = sprite->y;
+	if (!sprite->visible)
+	{
+		sprite->x = x;
+		sprite->y = y;
+		return;
+	}
+	
+	lg_sprite_index(index, 0);
+	sprite->x = x;
+	sprite->y = y;
+	lg_sprite_index(index, 1);
+	lg_sprite_update_layer();
+	lg_element_invalidate_move(sprite_layer, 
+		old_x, old_y, sprite->bitmap->width, sprite->bitmap->height, 
+		x, y, sprite->bitmap->width, sprite->bitmap->height);
+}
+
+/*
+// changes the bitmap of a sprite
+*/
+void lg_sprite_set_bitmap(uint16_t index, const LG_BITMAP* bitmap)
+{
+	const LG_BITMAP* old_bitmap;
+	LG_SPRITE* sprite = &sprites[index];
+	
+	if (sprite->bitmap == bitmap)
+		return;
+	
+	old_bitmap = sprite->bitmap;
+	if (sprite->visible)
+		lg_sprite_index(index, 0);
+	sprite->bitmap = bitmap;
+	lg_bitmap_rewind(&sprite->cursor);
+	if (sprite->visible)
+	{
+		lg_sprite_index(index, 1);
+		lg_sprite_update_layer();
+		lg_element_invalidate_move(sprite_layer, 
+			sprite->x, sprite->y, old_bitmap->width, old_bitmap->height, 
+			sprite->x, sprite->y, bitmap->width, bitmap->height);
+	}
+}
+
+/*
+// shows or hides a sprite
+*/
+void lg_sprite_set_visibility(uint16_t index, char visible)
+{
+	LG_SPRITE* sprite = &sprites[index];
+	
+	if (sprite->visible != visible)
+	{
+		sprite->visible = visible;
+		lg_sprite_index(index, visible);
+		lg_sprite_update_layer();
+		lg_element_invalidate_rect(sprite_layer, sprite->x, sprite->y, 
+			sprite->bitmap->width, sprite->bitmap->height);
+	}
+}
+
+/*
+// releases the sprite layer, this happens if the application
+// removes it's element so we drop all sprites
+*/
+static void lg_sprite_layer_release(void* data)
+{
+	unsigned char i;
+	
+	for (i = 0; i < LG_MAX_SPRITES; i++)
+		sprites[i].in_use = 0;
+	for (i = 0; i < LG_MAX_SPRITE_ROWS; i++)
+		sprite_rows[i] = 0;
+	sprite_layer = -1;
+}
+
+/*
+// renders a span of the sprite layer. Only the sprites on the
+// scanline index are checked and they are drawn in index order
+*/
+static void lg_sprite_layer_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span)
+{
+	unsigned char i;
+	uint16_t x_start;
+	uint16_t x_end;
+	LG_SPRITE* sprite;
+	LG_SPRITE_MASK mask;
+	
+	if (y >= LG_MAX_SPRITE_ROWS)
+		return;
+	
+	for (i = 0, mask = sprite_rows[y]; mask; i++, mask >>= 1)
+	{
+		if (!(mask & 1))
+			continue;
+		
+		sprite = &sprites[i];
+		x_start = MAX(x, sprite->x);
+		x_end = MIN(x + width, sprite->x + sprite->bitmap->width);
+		if (x_start >= x_end)
+			continue;
+		
+		lg_bitmap_render(sprite->bitmap, &sprite->cursor, x_start - sprite->x, 
+			y - sprite->y, x_end - x_start, sprite->transparent, &span[x_start - x]);
+	}
+}
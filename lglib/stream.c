@@ -0,0 +1,91 @@
+/*
+ * lglib - Lightweight Graphics Library for Embedded Systems
+ * Copyright (C) 2013 Fernando Rodriguez (support@fernansoft.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "lg.h"
+#include "element.h"
+
+/*
+// opens a stream in memory
+*/
+void lg_stream_open_memory(LG_STREAM* stream, const unsigned char* data, uint32_t size)
+{
+	stream->data = data;
+	stream->size = size;
+	stream->read = NULL;
+	lg_stream_seek(stream, 0);
+}
+
+/*
+// opens a stream that is read through a callback
+*/
+void lg_stream_open(LG_STREAM* stream, LG_STREAM_READ read, void* context)
+{
+	stream->data = NULL;
+	stream->read = read;
+	stream->context = context;
+	stream->buffer_offset = 0;
+	stream->buffer_length = 0;
+	lg_stream_seek(stream, 0);
+}
+
+/*
+// moves the stream to an offset, the buffer is kept
+// in case we seek within it
+*/
+void lg_stream_seek(LG_STREAM* stream, uint32_t offset)
+{
+	stream->offset = offset;
+}
+
+/*
+// reads the next byte of the stream, past the end
+// of the stream it returns 0
+*/
+unsigned char lg_stream_byte(LG_STREAM* stream)
+{
+	if (stream->data != NULL)
+	{
+		if (stream->offset >= stream->size)
+			return 0;
+		return stream->data[stream->offset++];
+	}
+	/*
+	// refill the buffer from the read callback
+	*/
+	if (stream->offset < stream->buffer_offset || 
+		stream->offset >= stream->buffer_offset + stream->buffer_length)
+	{
+		stream->buffer_offset = stream->offset;
+		stream->buffer_length = stream->read(stream->context, stream->offset, 
+			stream->buffer, LG_STREAM_BUFFER_SIZE);
+		if (!stream->buffer_length)
+			return 0;
+	}
+	return stream->buffer[stream->offset++ - stream->buffer_offset];
+}
+
+/*
+// reads a 16 bit little endian value
+*/
+uint16_t lg_stream_word(LG_STREAM* stream)
+{
+	uint16_t value = lg_stream_byte(stream);
+	return value | ((uint16_t) lg_stream_byte(stream) << 8);
+}
@@ -0,0 +1,277 @@
+/*
+ * lglib - Lightweight Graphics Library for Embedded Systems
+ * Copyright (C) 2013 Fernando Rodriguez (support@fernansoft.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "font.h"
+#include "lg.h"
+#include "element.h"
+
+#define LG_MAX_TEXTBOXES		4
+#define LG_MAX_TEXTBOX_LINES	16
+
+typedef struct LG_TEXTBOX
+{
+	char in_use;
+	unsigned char align;
+	unsigned char size;
+	unsigned char spacing;
+	unsigned char line_spacing;
+	unsigned char line_count;
+	int16_t index;
+	uint16_t x;
+	uint16_t y;
+	uint16_t width;
+	LG_RGB color;
+	const char* text;
+	uint16_t line_start[LG_MAX_TEXTBOX_LINES];
+	unsigned char line_length[LG_MAX_TEXTBOX_LINES];
+	uint16_t line_x[LG_MAX_TEXTBOX_LINES];
+}
+LG_TEXTBOX;
+
+static LG_TEXTBOX textboxes[LG_MAX_TEXTBOXES];
+
+/*
+// prototypes
+*/
+static void lg_textbox_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span);
+static void lg_textbox_release(void* data);
+
+static const LG_ELEMENT_OPS textbox_ops = { lg_textbox_render, lg_textbox_release };
+
+/*
+// breaks the text into lines that fit the width of the text box
+// and computes where each line starts on the screen. Lines are
+// broken at new line characters and at the last space that fits,
+// words longer than a line are split
+*/
+static void lg_textbox_layout(LG_TEXTBOX* textbox)
+{
+	uint16_t pos = 0;
+	uint16_t end;
+	uint16_t last_space;
+	uint16_t char_width = (8 + textbox->spacing) * textbox->size;
+	uint16_t max_chars = textbox->width / char_width;
+	unsigned char length;
+	const char* text = textbox->text;
+	
+	if (!max_chars)
+		max_chars = 1;
+	if (max_chars > 255)
+		max_chars = 255;
+	
+	textbox->line_count = 0;
+	while (text[pos] && textbox->line_count < LG_MAX_TEXTBOX_LINES)
+	{
+		/*
+		// find the end of the line
+		*/
+		last_space = 0xFFFF;
+		for (end = pos; text[end] && text[end] != '\n' && end - pos < max_chars; end++)
+		{
+			if (text[end] == ' ')
+				last_space = end;
+		}
+		if (text[end] && text[end] != '\n' && text[end] != ' ' && last_space != 0xFFFF)
+			end = last_space;
+		/*
+		// don't count trailing spaces on the line width
+		*/
+		length = (unsigned char) (end - pos);
+		while (length && text[pos + length - 1] == ' ')
+			length--;
+		
+		textbox->line_start[textbox->line_count] = pos;
+		textbox->line_length[textbox->line_count] = length;
+		switch (textbox->align)
+		{
+			case LG_ALIGN_CENTER:
+				textbox->line_x[textbox->line_count] = textbox->x + (textbox->width - length * char_width) / 2;
+				break;
+			case LG_ALIGN_RIGHT:
+				textbox->line_x[textbox->line_count] = textbox->x + textbox->width - length * char_width;
+				break;
+			default:
+				textbox->line_x[textbox->line_count] = textbox->x;
+				break;
+		}
+		textbox->line_count++;
+		/*
+		// skip the new line or the spaces where the line was broken
+		*/
+		pos = end;
+		if (text[pos] == '\n')
+			pos++;
+		else
+			while (text[pos] == ' ')
+				pos++;
+	}
+}
+
+/*
+// gets the height of a text box
+*/
+static uint16_t lg_textbox_height(LG_TEXTBOX* textbox)
+{
+	if (!textbox->line_count)
+		return 0;
+	return textbox->line_count * (8 * textbox->size + textbox->line_spacing) - textbox->line_spacing;
+}
+
+/*
+// adds a text box to the display
+*/
+int16_t lg_textbox_add(const char* text, uint16_t x, uint16_t y, uint16_t width, 
+	unsigned char font_size, unsigned char spacing, unsigned char line_spacing, unsigned char align, LG_RGB color)
+{
+	int16_t i;
+	for (i = 0; i < LG_MAX_TEXTBOXES; i++)
+	{
+		if (!textboxes[i].in_use)
+		{
+			textboxes[i].text = text;
+			textboxes[i].x = x;
+			textboxes[i].y = y;
+			textboxes[i].width = width;
+			textboxes[i].size = font_size;
+			textboxes[i].spacing = spacing;
+			textboxes[i].line_spacing = line_spacing;
+			textboxes[i].align = align;
+			textboxes[i].color = color;
+			lg_textbox_layout(&textboxes[i]);
+			textboxes[i].index = lg_element_add(&textbox_ops, &textboxes[i], LG_LAYER_CONTENT, 
+				x, y, width, lg_textbox_height(&textboxes[i]));
+			if (textboxes[i].index >= 0)
+				textboxes[i].in_use = 1;
+			return textboxes[i].index;
+		}
+	}
+	return -1;
+}
+
+/*
+// releases a text box
+*/
+static void lg_textbox_release(void* data)
+{
+	((LG_TEXTBOX*) data)->in_use = 0;
+}
+
+/*
+// changes the text of a text box
+*/
+void lg_textbox_set_text(uint16_t index, const char* text)
+{
+	LG_TEXTBOX* textbox = (LG_TEXTBOX*) lg_element_get_data(index);
+	textbox->text = text;
+	lg_textbox_layout(textbox);
+	lg_element_set_bounds(index, textbox->x, textbox->y, textbox->width, lg_textbox_height(textbox));
+}
+
+/*
+// changes the alignment of a text box
+*/
+void lg_textbox_set_align(uint16_t index, unsigned char align)
+{
+	LG_TEXTBOX* textbox = (LG_TEXTBOX*) lg_element_get_data(index);
+	if (textbox->align != align)
+	{
+		textbox->align = align;
+		lg_textbox_layout(textbox);
+		lg_element_invalidate(index);
+	}
+}
+
+/*
+// sets the color of a text box
+*/
+void lg_textbox_set_color(uint16_t index, LG_RGB color)
+{
+	LG_TEXTBOX* textbox = (LG_TEXTBOX*) lg_element_get_data(index);
+	if (textbox->color != color)
+	{
+		textbox->color = color;
+		lg_element_invalidate(index);
+	}
+}
+
+/*
+// renders a span of a text box. The line is found from the
+// scanline and only that line's characters are looked at
+*/
+static void lg_textbox_render(void* data, uint16_t x, uint16_t y, uint16_t width, LG_RGB* span)
+{
+	uint16_t i;
+	uint16_t row;
+	uint16_t line_x;
+	uint16_t char_x;
+	uint16_t char_width;
+	uint16_t line_height;
+	unsigned char c;
+	unsigned char line;
+	unsigned char font_row;
+	unsigned char column;
+	unsigned char length;
+	const char* text;
+	LG_TEXTBOX* textbox = (LG_TEXTBOX*) data;
+	
+	line_height = 8 * textbox->size + textbox->line_spacing;
+	row = y - textbox->y;
+	line = row / line_height;
+	row -= line * line_height;
+	if (row >= 8 * textbox->size)
+		return;
+	font_row = row / textbox->size;
+	
+	/*
+	// skip the part of the span left of the line
+	*/
+	line_x = textbox->line_x[line];
+	length = textbox->line_length[line];
+	text = &textbox->text[textbox->line_start[line]];
+	char_width = (8 + textbox->spacing) * textbox->size;
+	if (x + width <= line_x)
+		return;
+	if (x < line_x)
+	{
+		i = line_x - x;
+		char_x = 0;
+		column = 0;
+	}
+	else
+	{
+		i = 0;
+		column = (x - line_x) / char_width;
+		char_x = (x - line_x) - column * char_width;
+	}
+	
+	for (; i < width && column < length; i++)
+	{
+		c = (unsigned char) text[column];
+		if ((char_x / textbox->size) < 8 && LG_GLYPH_PIXEL(c, font_row, char_x / textbox->size))
+		{
+			span[i] = textbox->color;
+		}
+		if (++char_x == char_width)
+		{
+			char_x = 0;
+			column++;
+		}
+	}
+}
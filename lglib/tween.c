@@ -0,0 +1,262 @@
+/*
+ * lglib - Lightweight Graphics Library for Embedded Systems
+ * Copyright (C) 2013 Fernando Rodriguez (support@fernansoft.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "lg.h"
+#include "element.h"
+
+#define LG_MAX_TWEENS		8
+
+/*
+// tween kinds, the number of channels that are interpolated
+*/
+#define LG_TWEEN_VALUE		1
+#define LG_TWEEN_POSITION	2
+#define LG_TWEEN_COLOR		3
+
+/*
+// 1.0 in the fixed point format used for progress
+*/
+#define LG_TWEEN_ONE		32768UL
+
+typedef struct LG_TWEEN
+{
+	char in_use;
+	char started;
+	unsigned char kind;
+	unsigned char easing;
+	uint16_t index;
+	uint16_t duration;
+	uint32_t start;
+	int16_t from[3];
+	int16_t to[3];
+	int16_t value[3];
+	union
+	{
+		LG_TWEEN_SET_VALUE value;
+		LG_TWEEN_SET_POSITION position;
+		LG_TWEEN_SET_COLOR color;
+	}
+	set;
+}
+LG_TWEEN;
+
+static LG_TWEEN tweens[LG_MAX_TWEENS];
+
+/*
+// allocates a tween
+*/
+static int16_t lg_tween_alloc(unsigned char kind, uint16_t index, uint16_t duration, unsigned char easing)
+{
+	int16_t i;
+	for (i = 0; i < LG_MAX_TWEENS; i++)
+	{
+		if (!tweens[i].in_use)
+		{
+			tweens[i].kind = kind;
+			tweens[i].index = index;
+			tweens[i].duration = duration;
+			tweens[i].easing = easing;
+			tweens[i].started = 0;
+			tweens[i].in_use = 1;
+			return i;
+		}
+	}
+	return -1;
+}
+
+/*
+// animates a value
+*/
+int16_t lg_tween_value(uint16_t index, LG_TWEEN_SET_VALUE set, 
+	int16_t from, int16_t to, uint16_t duration, unsigned char easing)
+{
+	int16_t i = lg_tween_alloc(LG_TWEEN_VALUE, index, duration, easing);
+	if (i >= 0)
+	{
+		tweens[i].set.value = set;
+		tweens[i].from[0] = from;
+		tweens[i].to[0] = to;
+		tweens[i].value[0] = from;
+		set(index, from);
+	}
+	return i;
+}
+
+/*
+// animates a position
+*/
+int16_t lg_tween_position(uint16_t index, LG_TWEEN_SET_POSITION set, 
+	uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t duration, unsigned char easing)
+{
+	int16_t i = lg_tween_alloc(LG_TWEEN_POSITION, index, duration, easing);
+	if (i >= 0)
+	{
+		tweens[i].set.position = set;
+		tweens[i].from[0] = tweens[i].value[0] = (int16_t) x1;
+		tweens[i].from[1] = tweens[i].value[1] = (int16_t) y1;
+		tweens[i].to[0] = (int16_t) x2;
+		tweens[i].to[1] = (int16_t) y2;
+		set(index, x1, y1);
+	}
+	return i;
+}
+
+/*
+// animates a color, each component is interpolated
+// separately
+*/
+int16_t lg_tween_color(uint16_t index, LG_TWEEN_SET_COLOR set, 
+	LG_RGB from, LG_RGB to, uint16_t duration, unsigned char easing)
+{
+	unsigned char c;
+	int16_t i = lg_tween_alloc(LG_TWEEN_COLOR, index, duration, easing);
+	if (i >= 0)
+	{
+		tweens[i].set.color = set;
+		for (c = 0; c < 3; c++)
+		{
+			tweens[i].from[c] = tweens[i].value[c] = (from >> (16 - (c << 3))) & 0xFF;
+			tweens[i].to[c] = (to >> (16 - (c << 3))) & 0xFF;
+		}
+		set(index, from);
+	}
+	return i;
+}
+
+/*
+// stops a tween where it is
+*/
+void lg_tween_stop(uint16_t tween)
+{
+	tweens[tween].in_use = 0;
+}
+
+/*
+// checks if a tween is still running
+*/
+char lg_tween_is_running(uint16_t tween)
+{
+	return tweens[tween].in_use;
+}
+
+/*
+// applies the easing function to the progress of a
+// tween (0 - LG_TWEEN_ONE)
+*/
+static uint16_t lg_tween_ease(uint32_t p, unsigned char easing)
+{
+	switch (easing)
+	{
+		case LG_EASE_IN:
+			return (uint16_t) ((p * p) >> 15);
+		
+		case LG_EASE_OUT:
+			p = LG_TWEEN_ONE - p;
+			return (uint16_t) (LG_TWEEN_ONE - ((p * p) >> 15));
+		
+		case LG_EASE_IN_OUT:
+			return (uint16_t) ((((p * p) >> 15) * (3 * LG_TWEEN_ONE - 2 * p)) >> 15);
+		
+		default:
+			return (uint16_t) p;
+	}
+}
+
+/*
+// advances all running tweens. All the changes made on a call
+// are repainted as a single batch, if the display is still busy
+// painting the previous batch nothing is changed and the tweens
+// skip the frames that are missed
+*/
+char lg_tween_process(uint32_t now)
+{
+	unsigned char i;
+	unsigned char c;
+	char changed;
+	char running = 0;
+	uint32_t elapsed;
+	uint16_t progress;
+	int16_t value;
+	LG_TWEEN* tween;
+	
+	for (i = 0; i < LG_MAX_TWEENS; i++)
+	{
+		if (tweens[i].in_use && !tweens[i].started)
+		{
+			tweens[i].start = now;
+			tweens[i].started = 1;
+		}
+		running |= tweens[i].in_use;
+	}
+	if (!running || lg_display_is_busy())
+		return running;
+	
+	running = 0;
+	lg_begin_update();
+	for (i = 0; i < LG_MAX_TWEENS; i++)
+	{
+		tween = &tweens[i];
+		if (!tween->in_use)
+			continue;
+		
+		elapsed = now - tween->start;
+		if (elapsed >= tween->duration)
+		{
+			progress = LG_TWEEN_ONE;
+			tween->in_use = 0;
+		}
+		else
+		{
+			progress = lg_tween_ease((elapsed << 15) / tween->duration, tween->easing);
+			running = 1;
+		}
+		
+		changed = 0;
+		for (c = 0; c < tween->kind; c++)
+		{
+			value = tween->from[c] + (int16_t) ((((int32_t) tween->to[c] - tween->from[c]) * progress) >> 15);
+			if (value != tween->value[c])
+			{
+				tween->value[c] = value;
+				changed = 1;
+			}
+		}
+		if (!changed)
+			continue;
+		
+		switch (tween->kind)
+		{
+			case LG_TWEEN_VALUE:
+				tween->set.value(tween->index, tween->value[0]);
+				break;
+			
+			case LG_TWEEN_POSITION:
+				tween->set.position(tween->index, (uint16_t) tween->value[0], (uint16_t) tween->value[1]);
+				break;
+			
+			case LG_TWEEN_COLOR:
+				tween->set.color(tween->index, ((LG_RGB) tween->value[0] << 16) |
+					((LG_RGB) tween->value[1] << 8) | (LG_RGB) tween->value[2]);
+				break;
+		}
+	}
+	lg_end_update();
+	return running;
+}